@@ -1,158 +1,100 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <cstring>
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <pthread.h>
 #include <utility>
 #include <vector>
 #include <signal.h>
-#include <regex>
+#include <sys/dispatch.h>
 #include "../../DataTypes/aircraft.h"
 #include "../../DataTypes/aircraft_data.h"
 #include "../../DataTypes/airspace.h"
+#include "../../DataTypes/simulation_engine.h"
+#include "../../DataTypes/slot_allocator.h"
+#include "../../DataTypes/active_index.h"
+#include "../../DataTypes/airspace_replay.h"
+#include "../../DataTypes/scenario_loader.h"
+#include "../../DataTypes/operator_command.h"
+#include "../../DataTypes/performance_metrics.h"
+
+// Aircraft this far outside the 100 km x 100 km sector have left for good
+#define AIRSPACE_LIMIT_XY 100000
+#define RETIRE_MARGIN 10000
+
+// How long a lockstep replay waits for the ComputerSystem to check a frame
+#define LOCKSTEP_TIMEOUT_MS 5000
 
 using namespace std;
 
-int shm_fd;
-Airspace *airspace = nullptr;
+AirspaceMapping airspace;
 vector<pair<time_t, AircraftData>> aircraft_queue;
 vector<Aircraft*> active_aircrafts;
-
-Airspace* init_shared_memory() {
+pthread_mutex_t aircrafts_lock = PTHREAD_MUTEX_INITIALIZER;   // guards active_aircrafts
+SimulationEngine* engine = nullptr;
+pthread_t retire_thread;
+volatile bool retiring = false;
+MetricCounter aircraft_spawned = metrics().counter("aircraftSpawned");
+MetricCounter aircraft_retired = metrics().counter("aircraftRetired");
+MetricGauge active_count = metrics().gauge("activeAircraft");
+
+void init_shared_memory(int capacity) {
 	cout << "Initializing Shared Memory..." << endl;
 
-	shm_fd = shm_open(AIRSPACE_SHM_NAME, O_CREAT | O_RDWR, 0666);
-	if (shm_fd == -1) {
-		perror("shm_open failed");
+	if (!airspace.create(AIRSPACE_SHM_NAME, capacity)) {
 		exit(EXIT_FAILURE);
 	}
 
-	if (ftruncate(shm_fd, sizeof(Airspace)) == -1) {
-	        perror("ftruncate failed for aircraft data");
-	        exit(EXIT_FAILURE);
-	}
-
-	void *airspace_shared_memory = mmap(NULL, sizeof(Airspace),
-										PROT_READ | PROT_WRITE, MAP_SHARED,
-										shm_fd, 0);
-	if (airspace_shared_memory == MAP_FAILED) {
-		perror("mmap failed");
-		exit(EXIT_FAILURE);
-	}
-
-	Airspace *airspace = static_cast<Airspace*>(airspace_shared_memory);
-
-	pthread_mutexattr_t attr;
-	pthread_mutexattr_init(&attr);
-	pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
-	pthread_mutex_init(&airspace->lock, &attr);
-
-	// Initialize the shared memory to 0x0
-	memset(airspace, 0, sizeof(Airspace));
-
-	cout << "Airspace shared memory initialized successfully...\n";
-	return airspace;
+	cout << "Airspace shared memory initialized successfully ("
+	     << capacity << " slots)...\n";
 }
 
-time_t parseToTimeT(const string& input) {
-    std::tm tm = {};
-    time_t now = time(NULL);
-
-    // epoch timestamp (digits only)
-    if (regex_match(input, regex("^\\d{9,}$"))) {
-        return static_cast<time_t>(stoll(input));
-    }
-
-    // "YYYY-MM-DD HH:MM:SS"
-    if (strptime(input.c_str(), "%Y-%m-%d %H:%M:%S", &tm)) {
-        return mktime(&tm);
-    }
-
-    // "YYYY-MM-DD"
-    if (strptime(input.c_str(), "%Y-%m-%d", &tm)) {
-        return mktime(&tm);
-    }
-
-    // "HH:MM:SS"
-    if (strptime(input.c_str(), "%H:%M:%S", &tm)) {
-        std::tm* now_tm = localtime(&now);
-        tm.tm_year = now_tm->tm_year;
-        tm.tm_mon = now_tm->tm_mon;
-        tm.tm_mday = now_tm->tm_mday;
-        return mktime(&tm);
-    }
-
-    // Relative seconds offset (e.g. "2", "15")
-	if (regex_match(input, regex("^\\d+$"))) {
-		int offset = stoi(input);
-		return now + offset;
-	}
-
-    cerr << "Invalid time format: " << input << endl;
-    return -1;
-}
-
-void load_aircraft_data_from_file(const string &file_path) {
+void load_aircraft_data_from_file(const string &file_path, int threads) {
     cout << "Reading aircraft data from file: " << file_path << endl;
 
-    ifstream file(file_path);
-    if (!file.is_open()) {
+    timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    Scenario scenario;
+    if (!loadScenarioFile(file_path.c_str(), scenario, threads)) {
         cerr << "Error: Unable to open file: " << file_path << endl;
         exit(EXIT_FAILURE);
     }
-
-    string line;
-    int aircraft_count = 0;
-
-    while (getline(file, line)) {
-        istringstream line_stream(line);
-        AircraftData aircraft_data;
-        string temp_time_str;
-
-        line_stream >> temp_time_str >> aircraft_data.id >> aircraft_data.x
-		            >> aircraft_data.y >> aircraft_data.z
-					>> aircraft_data.speedX >> aircraft_data.speedY
-					>> aircraft_data.speedZ;
-
-        aircraft_data.entryTime = parseToTimeT(temp_time_str);
-        aircraft_queue.emplace_back(aircraft_data.entryTime, aircraft_data);
-        aircraft_count++;
+    for (const ScenarioError& error : scenario.errors) {
+        cerr << file_path << ":" << error.line << ": " << error.message << endl;
     }
 
-    // Update number of aircrafts
-    pthread_mutex_lock(&airspace->lock);
-    airspace->aircraft_count = aircraft_count;
-    pthread_mutex_unlock(&airspace->lock);
+    aircraft_queue = std::move(scenario.aircraft);
+    int aircraft_count = aircraft_queue.size();
 
-    file.close();
-}
-
-void cleanup_shared_memory(const char* shm_name, int shm_fd, void* addr,
-						   size_t size) {
-	if (munmap(addr, size) == 0) {
-		cout << "Shared memory unmapped successfully." << endl;
-	} else {
-		perror("munmap failed");
-	}
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    cout << "Loaded " << aircraft_count << " aircraft from " << scenario.lines << " lines ("
+         << scenario.errors.size() << " rejected) in " << ms << " ms\n";
 
-	close(shm_fd);
-
-	if (shm_unlink(shm_name) == 0) {
-		std::cout << "Shared memory unlinked successfully." << std::endl;
-	} else {
-		perror("shm_unlink failed");
-	}
+    // Size the segment for the whole scenario up front, so spawning never
+    // has to resize it mid-run
+    airspace.grow(aircraft_count);
 
+    // Update number of aircrafts
+    airspace.beginWrite();
+    airspace.header()->aircraft_count = aircraft_count;
+    airspace.endWrite();
 }
 
 void verify_aircraft_data() {
     cout << "Verifying shared memory contents...\n";
 
-    pthread_mutex_lock(&airspace->lock);
+    static vector<AircraftData> snapshot;
+    airspace.read([&](const AirspaceView& view) {
+        snapshot.clear();
+        forEachActiveSlot(view, [&](int slot) {
+            snapshot.push_back(view.aircraft_data[slot]);
+        });
+    });
 
-    for (int i = 0; i < MAX_AIRCRAFT; i++) {
-        AircraftData* aircraft = &airspace->aircraft_data[i];
+    for (size_t i = 0; i < snapshot.size(); i++) {
+        AircraftData* aircraft = &snapshot[i];
 
         if (aircraft->id == 0) continue;
 
@@ -160,11 +102,23 @@ void verify_aircraft_data() {
 //        		  << " Entry Time: " << aircraft->entryTime
 //                  << " Position: (" << aircraft->x << ", " << aircraft->y << ", " << aircraft->z << ")"
 //                  << " Speed: (" << aircraft->speedX << ", " << aircraft->speedY << ", " << aircraft->speedZ << ")"
-//                  << " Stored at: " << &airspace->aircraft_data[i] << endl;
+//                  << endl;
 
     }
+}
 
-    pthread_mutex_unlock(&airspace->lock);
+// Lock-free in the common case; only a full segment takes the resize path
+SlotHandle acquire_slot() {
+    SlotHandle slot = allocateSlot(airspace.view());
+    while (!slot.valid()) {
+        if (!airspace.grow(airspace.capacity() + 1)) {
+            cerr << "[AirspaceManager] Unable to grow airspace past "
+                 << airspace.capacity() << " slots\n";
+            return INVALID_SLOT;
+        }
+        slot = allocateSlot(airspace.view());
+    }
+    return slot;
 }
 
 void spawn_aircrafts_by_time() {
@@ -184,6 +138,12 @@ void spawn_aircrafts_by_time() {
 //            std::cout << "[AirspaceManager] Injecting aircraft ID: " << data.id
 //                      << " at time: " << currentTime << std::endl;
 
+            SlotHandle slot = acquire_slot();
+            if (!slot.valid()) {
+                nextAircraftIndex++;
+                continue;
+            }
+
             Aircraft* a = new Aircraft(data.entryTime,
                                        data.id,
                                        data.x,
@@ -192,9 +152,15 @@ void spawn_aircrafts_by_time() {
                                        data.speedX,
                                        data.speedY,
                                        data.speedZ,
-                                       airspace);
+                                       &airspace,
+                                       slot);
+            pthread_mutex_lock(&aircrafts_lock);
             active_aircrafts.push_back(a);
+            pthread_mutex_unlock(&aircrafts_lock);
             a->startThreads();
+            engine->addSlot(a->shm_index);
+            aircraft_spawned.add();
+            active_count.add(1);
 
             nextAircraftIndex++;
         }
@@ -206,23 +172,228 @@ void spawn_aircrafts_by_time() {
 }
 
 
+// Stops the aircraft, then clears its record and frees the slot in one
+// write section, so readers never see a freed slot with a live record
+void retire_aircraft(Aircraft* a) {
+    engine->removeSlot(a->shm_index);
+    SlotHandle slot = a->slot;
+    delete a;
+
+    const AirspaceView& view = airspace.beginWrite();
+    retractActiveSlot(view, slot.slot);
+    memset(&view.aircraft_data[slot.slot], 0, sizeof(AircraftData));
+    syncHotFields(view, slot.slot);
+    releaseSlot(view, slot);
+    airspace.endWrite();
+    aircraft_retired.add();
+    active_count.add(-1);
+}
+
+bool has_departed(const AircraftData& a) {
+    return a.x < -RETIRE_MARGIN || a.y < -RETIRE_MARGIN ||
+           a.x > AIRSPACE_LIMIT_XY + RETIRE_MARGIN || a.y > AIRSPACE_LIMIT_XY + RETIRE_MARGIN;
+}
+
+void* retire_departed_aircrafts(void*) {
+    struct timespec period = {1, 0};
+    vector<Aircraft*> departed;
+
+    while (retiring) {
+        departed.clear();
+
+        pthread_mutex_lock(&aircrafts_lock);
+        for (size_t k = 0; k < active_aircrafts.size(); ) {
+            Aircraft* a = active_aircrafts[k];
+            AircraftData record;
+            airspace.read([&](const AirspaceView& view) {
+                record = view.aircraft_data[a->shm_index];
+            });
+
+            if (has_departed(record)) {
+                departed.push_back(a);
+                active_aircrafts[k] = active_aircrafts.back();
+                active_aircrafts.pop_back();
+            } else {
+                k++;
+            }
+        }
+        pthread_mutex_unlock(&aircrafts_lock);
+
+        for (Aircraft* a : departed) {
+            cout << "[AirspaceManager] Aircraft " << a->id << " left the airspace, slot "
+                 << a->shm_index << " recycled\n";
+            retire_aircraft(a);
+        }
+
+        nanosleep(&period, NULL);
+    }
+    return nullptr;
+}
+
+void start_retiring() {
+    retiring = true;
+    pthread_create(&retire_thread, NULL, retire_departed_aircrafts, NULL);
+}
+
+void stop_retiring() {
+    if (!retiring) return;
+    retiring = false;
+    pthread_join(retire_thread, NULL);
+}
+
 void start_aircrafts() {
 	for (Aircraft *a : active_aircrafts) {
 		a->startThreads();
 	}
 }
 
+void stop_simulation() {
+	if (engine == nullptr) return;
+	engine->stop();
+	cout << "[AirspaceManager] Simulation ran " << engine->ticks()
+	     << " ticks on " << engine->threadCount() << " thread(s), one airspace lock per tick\n";
+}
+
 void clean_up_aircrafts() {
+	stop_retiring();
+	pthread_mutex_lock(&aircrafts_lock);
 	for (Aircraft *a : active_aircrafts) {
 		delete a;
 	}
+	active_count.add(-(int64_t)active_aircrafts.size());
 	active_aircrafts.clear();
+	pthread_mutex_unlock(&aircrafts_lock);
+}
+
+// Resends a command from the recorded session to the OperatorConsole, the
+// way the DataDisplay does, so it goes through the same command chain.
+// Replayed aircraft have no IPC channels and the recording already holds
+// the command's effect, so it is tagged for the CommunicationSystem to
+// count rather than deliver.
+void send_history_command(const HistoryCommand& history) {
+    static int console_coid = -1;
+    if (console_coid == -1) console_coid = name_open(OPERATOR_CONSOLE_CHANNEL_NAME, 0);
+    if (console_coid == -1) {
+        cerr << "[AirspaceManager] OperatorConsole not running, command not replayed: "
+             << history.command << endl;
+        return;
+    }
+
+    string cmd = history.command;
+    if (cmd.compare(0, sizeof(REPLAY_COMMAND_PREFIX), REPLAY_COMMAND_PREFIX " ") != 0) {
+        cmd = REPLAY_COMMAND_PREFIX " " + cmd;
+    }
+    if (MsgSend(console_coid, cmd.c_str(), cmd.size() + 1, nullptr, 0) == -1) {
+        perror("[AirspaceManager] Failed to replay command");
+        name_close(console_coid);
+        console_coid = -1;
+    }
+}
+
+// True once the ComputerSystem reports frame n checked, false if it stays
+// silent for LOCKSTEP_TIMEOUT_MS
+bool wait_until_checked(Airspace* h, uint64_t n) {
+    uint64_t seen = shmEventValue(&h->frame_checked);
+    while (h->checked_frame.load(std::memory_order_acquire) < n) {
+        uint64_t now = waitShmEvent(&h->frame_checked, seen, LOCKSTEP_TIMEOUT_MS);
+        if (now == seen) return false;
+        seen = now;
+    }
+    return true;
+}
+
+// Feeds a flight recording into the airspace instead of simulating. With
+// speed > 0 frames are paced by their recorded timestamps divided by the
+// speed; speed 0 runs as fast as the ComputerSystem can check, one frame
+// at a time, so each frame is checked exactly once whatever the load.
+void run_replay(const char* recording_path, double speed, const char* history_path) {
+    FlightRecording recording;
+    if (!recording.open(recording_path)) exit(EXIT_FAILURE);
+
+    vector<HistoryCommand> history;
+    if (!loadOperatorHistory(history_path, history)) {
+        cout << "[AirspaceManager] No operator history at " << history_path << endl;
+    }
+    std::stable_sort(history.begin(), history.end(),
+                     [](const HistoryCommand& a, const HistoryCommand& b) {
+                         return a.when < b.when;
+                     });
+
+    uint64_t first = recording.firstFrame(), end = recording.endFrame();
+    cout << "[AirspaceManager] Replaying frames " << first << " to " << end
+         << " of " << recording_path << " at "
+         << (speed > 0 ? to_string(speed) + "x" : string("lockstep")) << " speed, "
+         << history.size() << " operator command(s)\n";
+
+    AirspaceReplay replay(&airspace);
+    Airspace* h = airspace.header();
+    bool lockstep = speed <= 0;
+    h->lockstep.store(lockstep ? 1 : 0, std::memory_order_release);
+
+    vector<RecordedAircraft> aircraft;
+    FrameHeader info;
+    size_t next_command = 0;
+    int64_t first_ns = 0;
+    uint64_t replayed = 0;
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (uint64_t f = first; f < end; f++) {
+        if (!recording.readFrame(f, aircraft, &info)) {
+            cerr << "[AirspaceManager] Frame " << f << " unreadable, skipped\n";
+            continue;
+        }
+        if (replayed == 0) first_ns = info.timestamp_ns;
+
+        if (speed > 0) {
+            int64_t offset_ns = (int64_t)((info.timestamp_ns - first_ns) / speed);
+            timespec due = start;
+            due.tv_sec += offset_ns / 1000000000;
+            due.tv_nsec += offset_ns % 1000000000;
+            if (due.tv_nsec >= 1000000000) {
+                due.tv_sec++;
+                due.tv_nsec -= 1000000000;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+        }
+
+        // Commands typed before the first frame kept concerned traffic
+        // the recording no longer holds
+        time_t frame_time = info.timestamp_ns / 1000000000;
+        while (next_command < history.size() && history[next_command].when <= frame_time) {
+            if (replayed > 0 || history[next_command].when == frame_time) {
+                send_history_command(history[next_command]);
+            }
+            next_command++;
+        }
+
+        uint64_t n = replay.apply(aircraft, frame_time);
+        replayed++;
+
+        if (lockstep && !wait_until_checked(h, n)) {
+            cerr << "[AirspaceManager] ComputerSystem did not check frame " << n
+                 << ", replaying the rest unsynchronized\n";
+            lockstep = false;
+            h->lockstep.store(0, std::memory_order_release);
+        }
+    }
+
+    h->lockstep.store(0, std::memory_order_release);
+    announceAirspaceFrame(h);
+
+    timespec stop;
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    double elapsed = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+    cout << "[AirspaceManager] Replayed " << replayed << " frames in " << elapsed
+         << " s (" << (elapsed > 0 ? replayed / elapsed : 0) << " frames/s), "
+         << history.size() - next_command << " command(s) after the last frame not sent\n";
 }
 
 void handle_termination(int signum) {
     std::cout << "[AirspaceManager] received signal " << signum << ", cleaning up...\n";
+    stop_simulation();
     clean_up_aircrafts();
-    cleanup_shared_memory(AIRSPACE_SHM_NAME, shm_fd, (void*) airspace, sizeof(Airspace));
+    airspace.close(true);
     std::cout << "Exiting...\n";
     exit(0);
 }
@@ -232,20 +403,44 @@ void setup_signal_handlers() {
     signal(SIGTERM, handle_termination);  // kill
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 	setup_signal_handlers();
-	airspace = init_shared_memory();
+
+	// AirspaceManager --replay [recording] [speed] [history]
+	// Plays a flight recording back instead of simulating the scenario
+	if (argc > 1 && strcmp(argv[1], "--replay") == 0) {
+		const char* recording_path = argc > 2 ? argv[2] : FLIGHT_RECORDER_PATH;
+		double speed = argc > 3 ? atof(argv[3]) : 1.0;
+		const char* history_path = argc > 4 ? argv[4] : OPERATOR_HISTORY_PATH;
+
+		init_shared_memory(DEFAULT_AIRSPACE_CAPACITY);
+		run_replay(recording_path, speed, history_path);
+
+		cout << "Press Enter to end the replay..." << endl;
+		cin.get();
+		airspace.close(true);
+		return EXIT_SUCCESS;
+	}
+
+	// Optional arguments: number of simulation worker threads, initial slot
+	// capacity (the segment still grows to fit the scenario), threads used
+	// to parse the scenario file
+	int workers = argc > 1 ? atoi(argv[1]) : 1;
+	int capacity = argc > 2 ? atoi(argv[2]) : DEFAULT_AIRSPACE_CAPACITY;
+	int loader_threads = argc > 3 ? atoi(argv[3]) : 1;
+	init_shared_memory(std::max(1, capacity));
+	engine = new SimulationEngine(&airspace, workers);
 	struct timespec wait_time = {1, 0};
 
-	load_aircraft_data_from_file("/tmp/aircraft_data.txt");
+	load_aircraft_data_from_file("/tmp/aircraft_data.txt", loader_threads);
 	nanosleep(&wait_time, NULL);
 	verify_aircraft_data();
 
 	cout << "\nIterating through aircraft data using shared memory limits:\n";
-	for (size_t i = 0; i < MAX_AIRCRAFT; i++) {
-		if (airspace->aircraft_data[i].id == 0) continue;
-		cout << "Aircraft ID: " << airspace->aircraft_data[i].id << endl;
-	}
+	const AirspaceView& view = airspace.view();
+	forEachActiveSlot(view, [&](int slot) {
+		cout << "Aircraft ID: " << view.aircraft_data[slot].id << endl;
+	});
 
 	// Sort the aircraft in queue according to entry time
 	std::sort(aircraft_queue.begin(), aircraft_queue.end(),
@@ -257,14 +452,16 @@ int main() {
 //	cout << "Press Enter to start airspace simulation..." << endl;
 //	cin.get();
 
+	engine->start();
+	start_retiring();
 	spawn_aircrafts_by_time();
 
 
 	cout << "Press Enter to end airspace simulation..." << endl;
 	cin.get();
 
+	stop_simulation();
 	clean_up_aircrafts();
-	cleanup_shared_memory(AIRSPACE_SHM_NAME, shm_fd, (void *)airspace,
-						  sizeof(Airspace));
+	airspace.close(true);
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,64 @@
+#include <cstring>
+#include <iostream>
+#include "bench_common.h"
+
+// Benchmarks [suite...] [--json file] [--label text]
+//
+// Runs the named suites, or all of them. --json appends the kernel
+// results to file as JSON lines tagged with the label (a commit id, say),
+// so runs can be compared across commits.
+
+struct Suite {
+    const char* name;
+    void (*run)();
+};
+
+static const Suite suites[] = {
+    {"separation",  bench_separation_grid},
+    {"simd",        bench_separation_simd},
+    {"simulation",  bench_simulation_engine},
+    {"alerts",      bench_alert_ring},
+    {"connections", bench_connection_cache},
+    {"commands",    bench_command_latency},
+    {"recorder",    bench_flight_recorder},
+    {"scenario",    bench_scenario_loader},
+    {"timing",      bench_timing_logger},
+    {"kernels",     bench_kernels},
+    {"displays",    bench_display_load},
+};
+
+int main(int argc, char* argv[]) {
+    std::vector<const Suite*> selected;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            bench_json = fopen(argv[++i], "a");
+            if (bench_json == nullptr) {
+                perror("Unable to open JSON output");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            bench_label = argv[++i];
+        } else {
+            const Suite* found = nullptr;
+            for (const Suite& s : suites) {
+                if (strcmp(argv[i], s.name) == 0) found = &s;
+            }
+            if (found == nullptr) {
+                std::cerr << "Unknown suite " << argv[i] << "; suites are:";
+                for (const Suite& s : suites) std::cerr << " " << s.name;
+                std::cerr << "\n";
+                return 1;
+            }
+            selected.push_back(found);
+        }
+    }
+
+    if (selected.empty()) {
+        for (const Suite& s : suites) selected.push_back(&s);
+    }
+    for (const Suite* s : selected) s->run();
+
+    if (bench_json != nullptr) fclose(bench_json);
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include "bench_common.h"
+#include "../../DataTypes/alert_ring.h"
+
+#define ALERT_BENCH_PER_PRODUCER 200000
+
+struct AlertProducer {
+    AlertRing* ring;
+    int producer;
+    long rejected;                      // pushes refused by a full ring
+};
+
+std::atomic<bool> alert_consumer_running;
+long alert_consumed;
+
+void* alert_producer_thread(void* arg) {
+    AlertProducer* p = static_cast<AlertProducer*>(arg);
+    AlertRecord record = {};
+    record.kind = ALERT_LOSS_OF_SEPARATION;
+    record.aircraft1 = p->producer;
+
+    // A refused push is retried, so every alert is appended and drained
+    // and the rate is the one the consumer keeps up with, not that of
+    // bouncing off a full ring
+    for (int i = 0; i < ALERT_BENCH_PER_PRODUCER; i++) {
+        record.aircraft2 = i;
+        while (!pushAlert(p->ring, record)) {
+            p->rejected++;
+            sched_yield();
+        }
+    }
+    return nullptr;
+}
+
+void* alert_consumer_thread(void* arg) {
+    AlertRing* ring = static_cast<AlertRing*>(arg);
+    AlertRecord batch[ALERT_DRAIN_BATCH];
+    while (true) {
+        // The flag is read before draining, so an empty drain that ends the
+        // loop came after the last producer had finished
+        bool running = alert_consumer_running;
+        int count = drainAlerts(ring, batch, ALERT_DRAIN_BATCH);
+        alert_consumed += count;
+        if (count == 0 && !running) break;
+    }
+    return nullptr;
+}
+
+// Checker threads pushing alerts while one console thread drains in
+// batches. Times every alert from push to drain; "full %" is the share of
+// push attempts a full ring refused, which the ComputerSystem would have
+// dropped.
+void bench_alert_ring() {
+    const int producer_counts[] = {1, 2, 4};
+
+    std::cout << "== Alert ring: producers push, one consumer drains in batches of "
+              << ALERT_DRAIN_BATCH << " ==\n";
+    std::cout << std::left
+              << std::setw(12) << "producers"
+              << std::setw(14) << "ns/alert"
+              << std::setw(16) << "alerts/s"
+              << std::setw(12) << "delivered"
+              << std::setw(12) << "full %" << "\n";
+
+    for (int producers : producer_counts) {
+        // Aligned for its cache-line members, as the production mapping is
+        void* memory = nullptr;
+        if (posix_memalign(&memory, alignof(AlertRing), sizeof(AlertRing)) != 0) {
+            perror("Unable to allocate alert ring");
+            return;
+        }
+        AlertRing* ring = static_cast<AlertRing*>(memory);
+        memset(memory, 0, sizeof(AlertRing));
+        initAlertRing(ring);
+
+        alert_consumer_running = true;
+        alert_consumed = 0;
+        pthread_t consumer;
+        pthread_create(&consumer, NULL, alert_consumer_thread, ring);
+
+        std::vector<pthread_t> threads(producers);
+        std::vector<AlertProducer> args(producers);
+        timespec start = now_mono();
+        for (int p = 0; p < producers; p++) {
+            args[p] = {ring, p, 0};
+            pthread_create(&threads[p], NULL, alert_producer_thread, &args[p]);
+        }
+        for (pthread_t t : threads) pthread_join(t, NULL);
+        alert_consumer_running = false;
+        pthread_join(consumer, NULL);
+        double sec = elapsed_sec(start, now_mono());
+
+        long total = (long)producers * ALERT_BENCH_PER_PRODUCER;
+        long rejected = 0;
+        for (const AlertProducer& p : args) rejected += p.rejected;
+        std::cout << std::setw(12) << producers
+                  << std::setw(14) << std::fixed << std::setprecision(1) << sec * 1e9 / total
+                  << std::setw(16) << std::setprecision(0) << total / sec
+                  << std::setw(12) << alert_consumed
+                  << std::setw(12) << std::setprecision(1) << 100.0 * rejected / (total + rejected);
+        if (alert_consumed != total || (long)ring->dropped.load() != rejected) {
+            std::cout << " MISMATCH (" << ring->dropped.load() << " refused)";
+        }
+        std::cout << "\n";
+        free(ring);
+    }
+}
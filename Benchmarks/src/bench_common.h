@@ -0,0 +1,105 @@
+/*
+ * bench_common.h
+ *
+ * Timing and synthetic traffic helpers shared by the benchmarks.
+ */
+
+#ifndef BENCH_COMMON_H_
+#define BENCH_COMMON_H_
+
+#include <cstdio>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+#include "../../DataTypes/aircraft_data.h"
+#include "../../DataTypes/airspace.h"
+
+#define MIN_BENCH_SEC 0.2
+
+inline timespec now_mono() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts;
+}
+
+inline double elapsed_sec(const timespec& start, const timespec& end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Random traffic spread over the radar volume (100 km x 100 km, 15000-25000 m)
+inline std::vector<AircraftData> make_traffic(int count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> horizontal(0, 100000);
+    std::uniform_real_distribution<double> altitude(15000, 25000);
+    std::uniform_real_distribution<double> speed(-400, 400);
+
+    std::vector<AircraftData> traffic(count);
+    for (int i = 0; i < count; i++) {
+        AircraftData& a = traffic[i];
+        a = {};
+        a.id = i + 1;
+        a.x = horizontal(rng);
+        a.y = horizontal(rng);
+        a.z = altitude(rng);
+        a.speedX = speed(rng);
+        a.speedY = speed(rng);
+        a.speedZ = speed(rng) / 10;
+    }
+    return traffic;
+}
+
+// SoA copy of the same traffic, laid out like the airspace hot arrays
+struct TrafficSoA {
+    std::vector<double> x, y, z, vx, vy, vz;
+    std::vector<uint8_t> active;
+
+    explicit TrafficSoA(const std::vector<AircraftData>& traffic) {
+        for (const AircraftData& a : traffic) {
+            x.push_back(a.x); y.push_back(a.y); z.push_back(a.z);
+            vx.push_back(a.speedX); vy.push_back(a.speedY); vz.push_back(a.speedZ);
+            active.push_back(a.id != 0);
+        }
+    }
+
+    SoAView view() const {
+        return {x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data(), active.data()};
+    }
+};
+
+// Runs fn until MIN_BENCH_SEC has passed and returns the mean seconds per call
+template <typename Fn>
+double time_per_call(Fn fn, long& result) {
+    int reps = 0;
+    timespec start = now_mono();
+    double elapsed = 0;
+    do {
+        result = fn();
+        // Every result counts and memory may have changed, so a pass over
+        // constant input is neither dropped nor hoisted out of the loop
+        asm volatile("" : : "g"(result) : "memory");
+        reps++;
+        elapsed = elapsed_sec(start, now_mono());
+    } while (elapsed < MIN_BENCH_SEC);
+    return elapsed / reps;
+}
+
+void bench_separation_grid();
+void bench_separation_simd();
+void bench_simulation_engine();
+void bench_alert_ring();
+void bench_connection_cache();
+void bench_command_latency();
+void bench_flight_recorder();
+void bench_scenario_loader();
+void bench_timing_logger();
+void bench_kernels();
+void bench_display_load();
+
+// Kernel results also go to bench_json, one JSON object per line tagged
+// with bench_label, when Benchmarks is run with --json
+extern FILE* bench_json;
+extern std::string bench_label;
+void report_kernel(const char* kernel, int n, double sec_per_op);
+
+#endif /* BENCH_COMMON_H_ */
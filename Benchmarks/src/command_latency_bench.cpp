@@ -0,0 +1,131 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "bench_common.h"
+#include "../../DataTypes/command_ring.h"
+
+// Operator -> ComputerSystem -> CommunicationSystem, one process per stage
+// like the real chain, with both rings in a shared mapping. The operator
+// sends one command at a time and waits for it to arrive, so each sample
+// is a full two-hop wakeup from sleep, not a queued batch.
+#define LATENCY_SAMPLES 5000
+#define POLL_SAMPLES 100
+#define POLL_PERIOD_MS 10     // the real stages polled every 1000 ms
+
+struct LatencyBenchShm {
+    CommandRing operator_ring;
+    CommandRing comm_ring;
+    std::atomic<bool> stop;
+    std::atomic<int> delivered;
+    int64_t latency_ns[LATENCY_SAMPLES];
+};
+
+inline int64_t mono_ns() {
+    timespec ts = now_mono();
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void poll_sleep() {
+    timespec period = {0, POLL_PERIOD_MS * 1000000L};
+    nanosleep(&period, NULL);
+}
+
+void forward_stage(LatencyBenchShm* shm, bool polling) {
+    while (!shm->stop) {
+        uint64_t arrived = shmEventValue(&shm->operator_ring.not_empty);
+        while (const CommandSlot* slot = peekCommand(&shm->operator_ring)) {
+            if (!pushCommand(&shm->comm_ring, slot->command)) break;
+            popCommand(&shm->operator_ring);
+        }
+        if (polling) poll_sleep();
+        else waitShmEvent(&shm->operator_ring.not_empty, arrived);
+    }
+}
+
+void deliver_stage(LatencyBenchShm* shm, bool polling) {
+    while (!shm->stop) {
+        uint64_t arrived = shmEventValue(&shm->comm_ring.not_empty);
+        while (const CommandSlot* slot = peekCommand(&shm->comm_ring)) {
+            int64_t sent = slot->command.timestamp;
+            popCommand(&shm->comm_ring);
+            int n = shm->delivered.load();
+            if (n < LATENCY_SAMPLES) shm->latency_ns[n] = mono_ns() - sent;
+            shm->delivered.store(n + 1);
+        }
+        if (polling) poll_sleep();
+        else waitShmEvent(&shm->comm_ring.not_empty, arrived);
+    }
+}
+
+void run_latency(const char* mode, bool polling, int samples) {
+    void* addr = mmap(NULL, sizeof(LatencyBenchShm), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        perror("[Benchmarks] mmap");
+        return;
+    }
+    memset(addr, 0, sizeof(LatencyBenchShm));
+    LatencyBenchShm* shm = static_cast<LatencyBenchShm*>(addr);
+    initCommandRing(&shm->operator_ring);
+    initCommandRing(&shm->comm_ring);
+
+    pid_t forwarder = fork();
+    if (forwarder == 0) { forward_stage(shm, polling); _exit(0); }
+    pid_t deliverer = fork();
+    if (deliverer == 0) { deliver_stage(shm, polling); _exit(0); }
+
+    timespec gap = {0, 200000};    // let both stages fall asleep again
+    for (int i = 0; i < samples; i++) {
+        nanosleep(&gap, NULL);
+        OperatorCommand cmd = {};
+        cmd.aircraft_id = i;
+        cmd.timestamp = mono_ns();
+        pushCommand(&shm->operator_ring, cmd);
+        while (shm->delivered.load() <= i) sched_yield();
+    }
+
+    shm->stop = true;
+    signalShmEvent(&shm->operator_ring.not_empty);
+    signalShmEvent(&shm->comm_ring.not_empty);
+    waitpid(forwarder, NULL, 0);
+    waitpid(deliverer, NULL, 0);
+
+    std::vector<int64_t> latency(shm->latency_ns, shm->latency_ns + samples);
+    std::sort(latency.begin(), latency.end());
+    double mean = 0;
+    for (int64_t l : latency) mean += l;
+    mean /= samples;
+
+    std::cout << std::setw(26) << mode << std::setw(10) << samples
+              << std::fixed << std::setprecision(1)
+              << std::setw(14) << mean / 1e3
+              << std::setw(14) << latency[samples / 2] / 1e3
+              << std::setw(14) << latency[samples * 99 / 100] / 1e3
+              << std::setw(14) << latency.back() / 1e3 << "\n";
+
+    munmap(addr, sizeof(LatencyBenchShm));
+}
+
+void bench_command_latency() {
+    std::cout << "== Operator command latency, operator -> computer -> communication (3 processes) ==\n";
+    std::cout << std::left
+              << std::setw(26) << "wakeup"
+              << std::setw(10) << "samples"
+              << std::setw(14) << "mean us"
+              << std::setw(14) << "p50 us"
+              << std::setw(14) << "p99 us"
+              << std::setw(14) << "max us" << "\n";
+
+    run_latency("shm event", false, LATENCY_SAMPLES);
+
+    char mode[40];
+    snprintf(mode, sizeof(mode), "poll every %d ms", POLL_PERIOD_MS);
+    run_latency(mode, true, POLL_SAMPLES);
+}
@@ -0,0 +1,154 @@
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "bench_common.h"
+#include "../../DataTypes/connection_cache.h"
+
+// Stand-in for the QNX name server on Linux: each aircraft listens on an
+// abstract unix socket named like its channel, connect() plays name_open()
+// and a request/reply round trip plays MsgSend()/MsgReply().
+#define CONN_BENCH_AIRCRAFT 32
+#define CONN_BENCH_MESSAGE 128
+
+std::atomic<bool> channel_server_running;
+
+sockaddr_un channel_address(int id, socklen_t& len) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    int n = snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1, "bench/Aircraft%d", id);
+    len = offsetof(sockaddr_un, sun_path) + 1 + n;
+    return addr;
+}
+
+int open_bench_channel(int id) {
+    socklen_t len;
+    sockaddr_un addr = channel_address(id, len);
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd == -1) return -1;
+    if (connect(fd, (sockaddr*)&addr, len) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int send_bench_message(int fd) {
+    char msg[CONN_BENCH_MESSAGE] = {}, reply[CONN_BENCH_MESSAGE];
+    if (send(fd, msg, sizeof(msg), MSG_NOSIGNAL) == -1) return -1;
+    return recv(fd, reply, sizeof(reply), 0) > 0 ? 0 : -1;
+}
+
+// Accepts on every aircraft's socket and echoes each request
+void* channel_server_thread(void* arg) {
+    std::vector<pollfd>& fds = *static_cast<std::vector<pollfd>*>(arg);
+    char buffer[CONN_BENCH_MESSAGE];
+
+    while (channel_server_running) {
+        if (poll(fds.data(), fds.size(), 10) <= 0) continue;
+
+        size_t count = fds.size();
+        for (size_t k = 0; k < count; k++) {
+            if (!(fds[k].revents & (POLLIN | POLLHUP))) continue;
+
+            if (k < CONN_BENCH_AIRCRAFT) {
+                int client = accept(fds[k].fd, NULL, NULL);
+                if (client != -1) fds.push_back({client, POLLIN, 0});
+            } else {
+                ssize_t n = recv(fds[k].fd, buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    close(fds[k].fd);
+                    fds[k].fd = -1;
+                } else {
+                    send(fds[k].fd, buffer, n, MSG_NOSIGNAL);
+                }
+            }
+        }
+
+        // Forget closed connections
+        size_t kept = CONN_BENCH_AIRCRAFT;
+        for (size_t k = CONN_BENCH_AIRCRAFT; k < fds.size(); k++) {
+            if (fds[k].fd != -1) fds[kept++] = fds[k];
+        }
+        fds.resize(kept);
+    }
+
+    for (pollfd& p : fds) if (p.fd != -1) close(p.fd);
+    return nullptr;
+}
+
+void print_conn_row(const char* mode, double sec_per_send, const ConnectionCache* cache) {
+    std::cout << std::setw(28) << mode
+              << std::setw(14) << std::fixed << std::setprecision(2) << sec_per_send * 1e6;
+    if (cache != nullptr) {
+        double total = cache->hits() + cache->misses();
+        std::cout << std::setw(12) << std::setprecision(1) << 100.0 * cache->hits() / total
+                  << std::setw(12) << cache->evictions();
+    } else {
+        std::cout << std::setw(12) << "-" << std::setw(12) << "-";
+    }
+    std::cout << "\n";
+}
+
+void bench_connection_cache() {
+    std::vector<pollfd> fds;
+    for (int id = 0; id < CONN_BENCH_AIRCRAFT; id++) {
+        socklen_t len;
+        sockaddr_un addr = channel_address(id, len);
+        int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+        if (fd == -1 || bind(fd, (sockaddr*)&addr, len) == -1 || listen(fd, 64) == -1) {
+            perror("[Benchmarks] channel socket");
+            return;
+        }
+        fds.push_back({fd, POLLIN, 0});
+    }
+
+    channel_server_running = true;
+    pthread_t server;
+    pthread_create(&server, NULL, channel_server_thread, &fds);
+
+    std::cout << "== Aircraft send, " << CONN_BENCH_AIRCRAFT
+              << " aircraft round robin: open per send vs connection cache ==\n";
+    std::cout << std::left
+              << std::setw(28) << "mode"
+              << std::setw(14) << "us/send"
+              << std::setw(12) << "hit %"
+              << std::setw(12) << "evictions" << "\n";
+
+    long sent = 0;
+    int next = 0;
+    double uncached = time_per_call([&] {
+        int id = next++ % CONN_BENCH_AIRCRAFT;
+        int fd = open_bench_channel(id);
+        if (fd == -1) return sent;
+        if (send_bench_message(fd) == 0) sent++;
+        close(fd);
+        return sent;
+    }, sent);
+    print_conn_row("open/send/close", uncached, nullptr);
+
+    const size_t sizes[] = {64, CONN_BENCH_AIRCRAFT / 2};
+    for (size_t size : sizes) {
+        ConnectionCache cache(open_bench_channel, [](int fd) { close(fd); }, size);
+        next = 0;
+        double cached = time_per_call([&] {
+            int id = next++ % CONN_BENCH_AIRCRAFT;
+            if (cache.send(id, send_bench_message) == 0) sent++;
+            return sent;
+        }, sent);
+
+        char mode[40];
+        snprintf(mode, sizeof(mode), "cached, LRU of %zu", size);
+        print_conn_row(mode, cached, &cache);
+    }
+
+    channel_server_running = false;
+    pthread_join(server, NULL);
+}
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "bench_common.h"
+#include "../../DataTypes/display_client.h"
+#include "../../DataTypes/display_publisher.h"
+#include "../../DataTypes/latency_histogram.h"
+
+#define DISPLAY_LOAD_CLIENTS 50
+#define DISPLAY_LOAD_AIRCRAFT 10000
+#define DISPLAY_LOAD_HZ 10              // publications per second
+#define DISPLAY_LOAD_SEC 3
+
+// Sectors and altitude bands of the kind controller positions watch: one
+// in five sees the whole airspace, the rest a zoomed sector, some only a
+// band of flight levels
+static Viewport position_filter(int i) {
+    Viewport v;
+    if (i % 5 == 0) return v;
+    static const double zooms[] = {2, 4, 8, 16};
+    v.setZoom(zooms[i % 4]);
+    v.moveTo((i * 37 % 100) * 1000.0, (i * 61 % 100) * 1000.0);
+    if (i % 3 == 0) {
+        v.floor = 15000 + (i % 4) * 2500;
+        v.ceiling = v.floor + 2500;
+    }
+    return v;
+}
+
+struct PositionResult {
+    Viewport filter;
+    uint64_t frames = 0;
+    uint64_t skipped = 0;
+    LatencyHistogram latency;
+};
+
+// One headless display: draws each publication it gets to, as
+// DataDisplaySystem --headless does, without the screen
+static void run_position(DisplaySegment* segment, PositionResult* result,
+                         const std::atomic<bool>* stop) {
+    DisplayClient client(segment);
+    client.attach(getpid(), result->filter);
+    DisplayFrame frame;
+
+    while (!stop->load(std::memory_order_relaxed)) {
+        if (!client.waitForPublication(100)) continue;
+        int64_t latency = client.render(frame);
+        if (latency >= 0) result->latency.record(latency);
+    }
+    result->frames = client.framesDrawn();
+    result->skipped = client.publicationsSkipped();
+}
+
+static double to_us(uint64_t ns) {
+    return ns / 1000.0;
+}
+
+// 50 displays with their own filters on one publication of 10k aircraft;
+// latency is from the end of a publish to a position's frame composed
+void bench_display_load() {
+    std::cout << "== Display load: " << DISPLAY_LOAD_CLIENTS << " headless positions, "
+              << DISPLAY_LOAD_AIRCRAFT << " aircraft, " << DISPLAY_LOAD_HZ
+              << " publications/s for " << DISPLAY_LOAD_SEC << " s ==\n";
+
+    DisplaySegment* segment = static_cast<DisplaySegment*>(calloc(1, sizeof(DisplaySegment)));
+    initDisplaySegment(segment);
+    DisplayPublisher publisher(segment);
+
+    std::vector<AircraftData> traffic = make_traffic(DISPLAY_LOAD_AIRCRAFT, 7);
+    for (AircraftData& a : traffic) a.detected = true;
+    publisher.publish(traffic, 0);
+
+    std::atomic<bool> stop(false);
+    std::vector<std::unique_ptr<PositionResult>> results;
+    std::vector<std::thread> positions;
+    for (int i = 0; i < DISPLAY_LOAD_CLIENTS; i++) {
+        results.emplace_back(new PositionResult());
+        results.back()->filter = position_filter(i);
+        positions.emplace_back(run_position, segment, results.back().get(), &stop);
+    }
+
+    // The ComputerSystem's side: move the traffic and publish, on a clock
+    LatencyHistogram publish_time;
+    long period_ns = 1000000000L / DISPLAY_LOAD_HZ;
+    double step = 1.0 / DISPLAY_LOAD_HZ;
+    timespec next = now_mono();
+    for (int frame = 1; frame <= DISPLAY_LOAD_HZ * DISPLAY_LOAD_SEC; frame++) {
+        next.tv_nsec += period_ns;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        for (AircraftData& a : traffic) {
+            a.x += a.speedX * step;
+            a.y += a.speedY * step;
+            a.z += a.speedZ * step;
+        }
+        timespec start = now_mono();
+        publisher.publish(traffic, frame);
+        publish_time.record((uint64_t)(elapsed_sec(start, now_mono()) * 1e9));
+    }
+
+    stop.store(true);
+    for (std::thread& t : positions) t.join();
+
+    std::cout << std::left
+              << std::setw(8) << "client"
+              << std::setw(28) << "filter"
+              << std::setw(8) << "frames"
+              << std::setw(9) << "skipped"
+              << std::setw(10) << "p50 us"
+              << std::setw(10) << "p99 us"
+              << std::setw(10) << "max us" << "\n";
+
+    LatencySnapshot all = {}, one;
+    for (int i = 0; i < DISPLAY_LOAD_CLIENTS; i++) {
+        PositionResult& r = *results[i];
+        r.latency.snapshot(one);
+
+        char filter[64];
+        snprintf(filter, sizeof(filter), "x%g @%.0f,%.0fkm z%.0f-%.0f", r.filter.zoom,
+                 r.filter.center_x / 1000, r.filter.center_y / 1000, r.filter.floor, r.filter.ceiling);
+        std::cout << std::setw(8) << i
+                  << std::setw(28) << filter
+                  << std::setw(8) << r.frames
+                  << std::setw(9) << r.skipped
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << to_us(one.percentile(0.5))
+                  << std::setw(10) << to_us(one.percentile(0.99))
+                  << std::setw(10) << to_us(one.max_ns) << "\n";
+
+        for (int b = 0; b < LATENCY_BUCKETS; b++) all.counts[b] += one.counts[b];
+        all.total += one.total;
+        all.sum_ns += one.sum_ns;
+        all.max_ns = std::max(all.max_ns, one.max_ns);
+    }
+
+    LatencySnapshot publishing;
+    publish_time.snapshot(publishing);
+    std::cout << std::fixed << std::setprecision(1)
+              << "all positions: " << all.total << " frames, p50 " << to_us(all.percentile(0.5))
+              << " us, p99 " << to_us(all.percentile(0.99)) << " us, max " << to_us(all.max_ns)
+              << " us\npublish: mean " << to_us((uint64_t)publishing.mean())
+              << " us, max " << to_us(publishing.max_ns) << " us\n";
+
+    std::cout << std::left
+              << std::setw(28) << "kernel"
+              << std::setw(10) << "n"
+              << std::setw(16) << "ns/op"
+              << std::setw(16) << "items/s" << "\n";
+    report_kernel("displayLoad p50", DISPLAY_LOAD_CLIENTS, all.percentile(0.5) / 1e9);
+    report_kernel("displayLoad p99", DISPLAY_LOAD_CLIENTS, all.percentile(0.99) / 1e9);
+    free(segment);
+}
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+#include "../../DataTypes/airspace_display.h"
+#include "../../DataTypes/conflict_prediction.h"
+#include "../../DataTypes/display_publisher.h"
+#include "../../DataTypes/display_viewport.h"
+#include "../../DataTypes/operator_command.h"
+#include "../../DataTypes/radar_coverage.h"
+#include "../../DataTypes/scenario_loader.h"
+#include "../../DataTypes/separation.h"
+#include "../../DataTypes/separation_simd.h"
+#include "../../DataTypes/spatial_grid.h"
+
+// The per-cycle kernels of the subsystems, each timed as one pass over n
+// items (aircraft, timestamps or commands) at several n. A pass is what
+// the subsystem does once per cycle, so ns/op is the cost of a cycle.
+
+static const int kernel_counts[] = {100, 1000, 10000};
+
+FILE* bench_json = nullptr;
+std::string bench_label;
+
+void report_kernel(const char* kernel, int n, double sec_per_op) {
+    double ns = sec_per_op * 1e9;
+    double items = n / sec_per_op;
+    std::cout << std::setw(28) << kernel
+              << std::setw(10) << n
+              << std::setw(16) << std::fixed << std::setprecision(0) << ns
+              << std::setw(16) << items << "\n";
+
+    if (bench_json != nullptr) {
+        fprintf(bench_json,
+                "{\"label\":\"%s\",\"kernel\":\"%s\",\"n\":%d,\"ns_per_op\":%.1f,\"items_per_s\":%.1f}\n",
+                bench_label.c_str(), kernel, n, ns, items);
+        fflush(bench_json);
+    }
+}
+
+// Loss of separation through the grid, as checkCurrentViolations
+static long current_violations(SpatialGrid& grid, const TrafficSoA& soa, int count) {
+    long conflicts = 0;
+    grid.rebuild(soa.view(), count);
+    grid.forEachCandidatePair([&](int i, int j) {
+        if (isLossOfSeparation(soa.x[i] - soa.x[j], soa.y[i] - soa.y[j], soa.z[i] - soa.z[j])) {
+            conflicts++;
+        }
+    });
+    return conflicts;
+}
+
+// Predicted conflicts row by row, as checkFutureViolations
+static long future_violations(const TrafficSoA& soa, int count,
+                              std::vector<int>& hits, std::vector<double>& times) {
+    long conflicts = 0;
+    SoAView view = soa.view();
+    for (int i = 0; i < count; i++) {
+        conflicts += conflictRow(view, i, i + 1, count, DEFAULT_LOOKAHEAD_SEC,
+                                 hits.data(), times.data());
+    }
+    return conflicts;
+}
+
+// Entry times in the four formats the scenario loader accepts
+static std::vector<std::string> make_timestamps(int count) {
+    std::vector<std::string> out;
+    time_t base = time(NULL);
+    char when[32];
+    for (int i = 0; i < count; i++) {
+        time_t t = base + i;
+        switch (i % 4) {
+        case 0: snprintf(when, sizeof(when), "%ld", (long)t); break;
+        case 1: strftime(when, sizeof(when), "%Y-%m-%d", localtime(&t)); break;
+        case 2: strftime(when, sizeof(when), "%H:%M:%S", localtime(&t)); break;
+        default: snprintf(when, sizeof(when), "%d", i % 600); break;
+        }
+        out.push_back(when);
+    }
+    return out;
+}
+
+static std::vector<std::string> make_commands(int count) {
+    static const char* const formats[] = {
+        "ChangeSpeed %d 120.5 -80 0", "ChangePosition %d 50000 42000 18000", "RequestDetails %d"
+    };
+    std::vector<std::string> out;
+    char line[96];
+    for (int i = 0; i < count; i++) {
+        snprintf(line, sizeof(line), formats[i % 3], i + 1);
+        out.push_back(line);
+    }
+    return out;
+}
+
+void bench_kernels() {
+    std::cout << "== Kernels: one op is one pass over n items ==\n";
+    std::cout << std::left
+              << std::setw(28) << "kernel"
+              << std::setw(10) << "n"
+              << std::setw(16) << "ns/op"
+              << std::setw(16) << "items/s" << "\n";
+
+    long result;
+    for (int n : kernel_counts) {
+        std::vector<AircraftData> traffic = make_traffic(n, 19);
+        TrafficSoA soa(traffic);
+
+        SpatialGrid grid;
+        report_kernel("checkCurrentViolations", n,
+                      time_per_call([&] { return current_violations(grid, soa, n); }, result));
+
+        std::vector<int> hits(n);
+        std::vector<double> times(n);
+        report_kernel("checkFutureViolations", n,
+                      time_per_call([&] { return future_violations(soa, n, hits, times); }, result));
+
+        std::vector<AircraftData> projected = traffic;
+        report_kernel("getProjectedPosition", n, time_per_call([&] {
+            for (AircraftData& a : projected) getProjectedPosition(a, 1.0);
+            return (long)projected[0].x;
+        }, result));
+
+        // A fifth of the contacts below the floor, so the test is not
+        // trivially predicted
+        std::vector<AircraftData> contacts = traffic;
+        for (int i = 0; i < n; i += 5) contacts[i].z -= 10000;
+        report_kernel("radarCoverage", n, time_per_call([&] {
+            long inside = 0;
+            for (const AircraftData& c : contacts) inside += inRadarCoverage(c.x, c.y, c.z);
+            return inside;
+        }, result));
+
+        std::vector<AircraftData> detected = traffic;
+        for (AircraftData& a : detected) a.detected = true;
+        // Display snapshots: made once per frame, then read by each display,
+        // whole or zoomed in 8x
+        DisplaySegment* segment = static_cast<DisplaySegment*>(calloc(1, sizeof(DisplaySegment)));
+        initDisplaySegment(segment);
+        DisplayPublisher publisher(segment);
+        report_kernel("publishDisplaySnapshot", n, time_per_call([&] {
+            return (long)publisher.publish(detected, 0);
+        }, result));
+
+        Viewport zoomed;
+        zoomed.setZoom(8);
+        DisplayFrame snapshot_frame;
+        report_kernel("readDisplaySnapshot", n, time_per_call([&] {
+            readDisplaySnapshot(segment, Viewport(), snapshot_frame);
+            return (long)snapshot_frame.cells[2][1];
+        }, result));
+        report_kernel("readDisplaySnapshot zoom 8", n, time_per_call([&] {
+            readDisplaySnapshot(segment, zoomed, snapshot_frame);
+            return (long)snapshot_frame.cells[2][1];
+        }, result));
+        free(segment);
+
+        std::vector<std::string> stamps = make_timestamps(n);
+        report_kernel("parseToTimeT", n, time_per_call([&] {
+            long sum = 0;
+            for (const std::string& s : stamps) sum += parseToTimeT(s);
+            return sum;
+        }, result));
+
+        std::vector<std::string> commands = make_commands(n);
+        report_kernel("handle_received_command", n, time_per_call([&] {
+            long sum = 0;
+            OperatorCommand cmd;
+            std::string type;
+            for (const std::string& c : commands) {
+                sum += parseOperatorCommand(c, cmd, type) ? cmd.aircraft_id : 0;
+            }
+            return sum;
+        }, result));
+    }
+    std::cout << "\n";
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <unistd.h>
+#include "bench_common.h"
+#include "../../DataTypes/flight_recorder.h"
+
+#define RECORDER_BENCH_PATH "/tmp/flight_recorder_bench.bin"
+#define RECORDER_BENCH_FRAMES 300
+#define MANEUVER_FRACTION 0.02      // aircraft changing velocity each sweep
+
+// 1 Hz sweeps with a few ms of jitter, traffic flying straight except for
+// a small share of maneuvering aircraft per sweep
+void bench_flight_recorder() {
+    const int counts[] = {1000, 10000};
+
+    std::cout << "== Flight recorder: one frame per 1 Hz sweep, "
+              << MANEUVER_FRACTION * 100 << "% of aircraft maneuvering per sweep ==\n";
+    std::cout << std::left
+              << std::setw(10) << "aircraft"
+              << std::setw(14) << "us/frame"
+              << std::setw(16) << "bytes/frame"
+              << std::setw(16) << "keyframe bytes"
+              << std::setw(14) << "records/frame" << "\n";
+
+    for (int count : counts) {
+        std::vector<AircraftData> traffic = make_traffic(count, 15);
+        std::vector<RecordedAircraft> frame(count);
+        for (int i = 0; i < count; i++) {
+            const AircraftData& a = traffic[i];
+            frame[i] = {i, a.id, a.x, a.y, a.z, a.speedX, a.speedY, a.speedZ, CONTACT_DETECTED};
+        }
+
+        FlightRecorder recorder;
+        if (!recorder.create(RECORDER_BENCH_PATH)) return;
+
+        std::mt19937 rng(15);
+        std::uniform_real_distribution<double> unit(0, 1);
+        std::uniform_int_distribution<int> jitter_ms(-5, 5);
+        int64_t t0 = (int64_t)time(NULL) * 1000000000LL;
+
+        double total_sec = 0;
+        for (int f = 0; f < RECORDER_BENCH_FRAMES; f++) {
+            for (RecordedAircraft& a : frame) {
+                a.x += a.vx;
+                a.y += a.vy;
+                a.z += a.vz;
+                if (unit(rng) < MANEUVER_FRACTION) a.vx += unit(rng) * 20 - 10;
+            }
+            int64_t sampled = t0 + f * 1000000000LL + jitter_ms(rng) * 1000000LL;
+
+            timespec start = now_mono();
+            recorder.record(frame, sampled);
+            total_sec += elapsed_sec(start, now_mono());
+        }
+
+        FlightRecording recording;
+        recording.open(RECORDER_BENCH_PATH);
+        FrameIndexEntry key = {};
+        recording.frameInfo(recording.firstFrame(), key);
+        double bytes = (double)recorder.dataHead() / RECORDER_BENCH_FRAMES;
+        double records = (bytes - sizeof(FrameHeader)) / sizeof(FlightRecord);
+
+        std::cout << std::setw(10) << count
+                  << std::setw(14) << std::fixed << std::setprecision(1)
+                  << total_sec / RECORDER_BENCH_FRAMES * 1e6
+                  << std::setw(16) << std::setprecision(0) << bytes
+                  << std::setw(16) << key.length
+                  << std::setw(14) << records << "\n";
+
+        recording.close();
+        recorder.close();
+    }
+
+    unlink(RECORDER_BENCH_PATH);
+}
@@ -0,0 +1,125 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <regex>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "bench_common.h"
+#include "../../DataTypes/scenario_loader.h"
+
+#define SCENARIO_BENCH_PATH "/tmp/scenario_bench.txt"
+#define SCENARIO_BENCH_AIRCRAFT 200000
+#define LEGACY_BENCH_AIRCRAFT 20000     // the old parser is too slow for more
+
+// The loader this replaces: a stream per line, two regexes and up to
+// three strptime formats per timestamp
+static time_t legacy_parse_time(const std::string& input) {
+    std::tm tm = {};
+    time_t now = time(NULL);
+    if (std::regex_match(input, std::regex("^\\d{9,}$"))) return std::stoll(input);
+    if (strptime(input.c_str(), "%Y-%m-%d %H:%M:%S", &tm)) return mktime(&tm);
+    if (strptime(input.c_str(), "%Y-%m-%d", &tm)) return mktime(&tm);
+    if (strptime(input.c_str(), "%H:%M:%S", &tm)) {
+        std::tm* now_tm = localtime(&now);
+        tm.tm_year = now_tm->tm_year;
+        tm.tm_mon = now_tm->tm_mon;
+        tm.tm_mday = now_tm->tm_mday;
+        return mktime(&tm);
+    }
+    if (std::regex_match(input, std::regex("^\\d+$"))) return now + std::stoi(input);
+    return -1;
+}
+
+static size_t legacy_load(const char* path) {
+    std::ifstream file(path);
+    std::string line;
+    size_t count = 0;
+    while (getline(file, line)) {
+        std::istringstream line_stream(line);
+        AircraftData a;
+        std::string time_str;
+        line_stream >> time_str >> a.id >> a.x >> a.y >> a.z >> a.speedX >> a.speedY >> a.speedZ;
+        a.entryTime = legacy_parse_time(time_str);
+        count++;
+    }
+    return count;
+}
+
+// Same traffic with the four entry time formats mixed in
+static size_t write_scenario(const char* path, int count) {
+    std::vector<AircraftData> traffic = make_traffic(count, 17);
+    std::ofstream out(path, std::ios::trunc);
+    time_t base = time(NULL);
+    char line[192];
+    for (int i = 0; i < count; i++) {
+        const AircraftData& a = traffic[i];
+        char when[32];
+        time_t t = base + i / 10;
+        switch (i % 4) {
+        case 0: snprintf(when, sizeof(when), "%ld", (long)t); break;
+        case 1: strftime(when, sizeof(when), "%Y-%m-%d", localtime(&t)); break;
+        case 2: strftime(when, sizeof(when), "%H:%M:%S", localtime(&t)); break;
+        default: snprintf(when, sizeof(when), "%d", i / 10); break;
+        }
+        snprintf(line, sizeof(line), "%s %d %.2f %.2f %.2f %.2f %.2f %.2f\n", when, a.id,
+                 a.x, a.y, a.z, a.speedX, a.speedY, a.speedZ);
+        out << line;
+    }
+    out.close();
+    return out.good() ? (size_t)out.tellp() : 0;
+}
+
+static void report(const char* name, size_t bytes, size_t aircraft, double sec) {
+    std::cout << std::setw(26) << name
+              << std::setw(12) << std::fixed << std::setprecision(1) << bytes / sec / 1e6
+              << std::setw(16) << std::setprecision(0) << aircraft / sec
+              << std::setw(10) << std::setprecision(2) << sec * 1e3 << "\n";
+}
+
+static double file_size(const char* path) {
+    std::ifstream in(path, std::ios::ate | std::ios::binary);
+    return in.tellg();
+}
+
+void bench_scenario_loader() {
+    std::cout << "== Scenario loader: mixed timestamp formats ==\n";
+    std::cout << std::left
+              << std::setw(26) << "loader"
+              << std::setw(12) << "MB/s"
+              << std::setw(16) << "aircraft/s"
+              << std::setw(10) << "ms" << "\n";
+
+    write_scenario(SCENARIO_BENCH_PATH, LEGACY_BENCH_AIRCRAFT);
+    size_t bytes = file_size(SCENARIO_BENCH_PATH);
+    timespec start = now_mono();
+    size_t loaded = legacy_load(SCENARIO_BENCH_PATH);
+    report("istringstream + regex", bytes, loaded, elapsed_sec(start, now_mono()));
+
+    write_scenario(SCENARIO_BENCH_PATH, SCENARIO_BENCH_AIRCRAFT);
+    std::vector<int> thread_counts = {1, 4};
+    int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 1 && cpus != 4) thread_counts.push_back(cpus);
+
+    // Warm the page cache so every run measures parsing
+    Scenario warm;
+    loadScenarioFile(SCENARIO_BENCH_PATH, warm);
+
+    for (int t : thread_counts) {
+        Scenario scenario;
+        start = now_mono();
+        loadScenarioFile(SCENARIO_BENCH_PATH, scenario, t);
+        double sec = elapsed_sec(start, now_mono());
+        if (!scenario.errors.empty()) {
+            std::cout << "line " << scenario.errors[0].line << ": "
+                      << scenario.errors[0].message << "\n";
+        }
+
+        std::string name = "mmap loader, " + std::to_string(t) + " thread(s)";
+        report(name.c_str(), scenario.bytes, scenario.aircraft.size(), sec);
+    }
+    std::cout << "\n";
+
+    unlink(SCENARIO_BENCH_PATH);
+}
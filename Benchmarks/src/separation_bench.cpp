@@ -0,0 +1,146 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+#include "../../DataTypes/separation.h"
+#include "../../DataTypes/spatial_grid.h"
+#include "../../DataTypes/conflict_prediction.h"
+#include "../../DataTypes/separation_simd.h"
+
+// Same loop shape as the original checkCurrentViolations
+long all_pairs_conflicts(const std::vector<AircraftData>& traffic, time_t now) {
+    long conflicts = 0;
+    int max = traffic.size();
+    for (int i = 0; i < max; i++) {
+        const AircraftData* a1 = &traffic[i];
+        if (a1->id == 0 || now < a1->entryTime) continue;
+
+        for (int j = i + 1; j < max; j++) {
+            const AircraftData* a2 = &traffic[j];
+            if (a2->id == 0 || now < a2->entryTime) continue;
+
+            if (isLossOfSeparation(a1->x - a2->x, a1->y - a2->y, a1->z - a2->z)) {
+                conflicts++;
+            }
+        }
+    }
+    return conflicts;
+}
+
+long grid_conflicts(SpatialGrid& grid, const std::vector<AircraftData>& traffic, time_t now) {
+    long conflicts = 0;
+    grid.rebuild(traffic.data(), traffic.size(), now);
+    grid.forEachCandidatePair([&](int i, int j) {
+        const AircraftData& a1 = traffic[i];
+        const AircraftData& a2 = traffic[j];
+        if (isLossOfSeparation(a1.x - a2.x, a1.y - a2.y, a1.z - a2.z)) {
+            conflicts++;
+        }
+    });
+    return conflicts;
+}
+
+// Same loop shape as checkFutureViolations before the SoA snapshot
+long all_pairs_predicted(const std::vector<AircraftData>& traffic, double lookahead) {
+    long conflicts = 0;
+    int max = traffic.size();
+    for (int i = 0; i < max; i++) {
+        for (int j = i + 1; j < max; j++) {
+            if (predictConflict(traffic[i], traffic[j], lookahead).time_to_los > 0) {
+                conflicts++;
+            }
+        }
+    }
+    return conflicts;
+}
+
+long simd_separation(const SoAView& view, int count, std::vector<int>& hits) {
+    long conflicts = 0;
+    for (int i = 0; i < count; i++) {
+        conflicts += separationRow(view, i, i + 1, count, hits.data());
+    }
+    return conflicts;
+}
+
+long simd_predicted(const SoAView& view, int count, double lookahead,
+                    std::vector<int>& hits, std::vector<double>& times) {
+    long conflicts = 0;
+    for (int i = 0; i < count; i++) {
+        conflicts += conflictRow(view, i, i + 1, count, lookahead, hits.data(), times.data());
+    }
+    return conflicts;
+}
+
+void print_row(int n, double base_sec, double new_sec, long found, long expected) {
+    std::cout << std::setw(10) << n
+              << std::setw(16) << std::fixed << std::setprecision(4) << base_sec * 1e3
+              << std::setw(16) << new_sec * 1e3
+              << std::setw(10) << std::setprecision(1) << base_sec / new_sec
+              << std::setw(12) << found;
+    if (found != expected) {
+        std::cout << " MISMATCH (baseline found " << expected << ")";
+    }
+    std::cout << "\n";
+}
+
+void print_header(const char* title, const char* base, const char* candidate) {
+    std::cout << "== " << title << " ==\n";
+    std::cout << std::left
+              << std::setw(10) << "aircraft"
+              << std::setw(16) << base
+              << std::setw(16) << candidate
+              << std::setw(10) << "speedup"
+              << std::setw(12) << "conflicts" << "\n";
+}
+
+void bench_separation_grid() {
+    const int sizes[] = {100, 1000, 10000, 50000};
+    time_t now = time(NULL);
+    SpatialGrid grid;
+
+    print_header("Separation check: all-pairs vs uniform grid", "all-pairs ms", "grid ms");
+
+    for (int n : sizes) {
+        std::vector<AircraftData> traffic = make_traffic(n, 320);
+
+        long brute = 0, binned = 0;
+        double brute_sec = time_per_call([&] { return all_pairs_conflicts(traffic, now); }, brute);
+        double grid_sec = time_per_call([&] { return grid_conflicts(grid, traffic, now); }, binned);
+        print_row(n, brute_sec, grid_sec, binned, brute);
+    }
+}
+
+void bench_separation_simd() {
+    const int sizes[] = {100, 1000, 10000};
+    const double lookahead = 120.0;
+    time_t now = time(NULL);
+
+    std::string kernel = std::string(simdKernelName()) + " ms";
+    print_header("Current separation: struct loop vs SoA kernel", "struct ms", kernel.c_str());
+
+    for (int n : sizes) {
+        std::vector<AircraftData> traffic = make_traffic(n, 320);
+        TrafficSoA soa(traffic);
+        std::vector<int> hits(n);
+
+        long base = 0, fast = 0;
+        double base_sec = time_per_call([&] { return all_pairs_conflicts(traffic, now); }, base);
+        double fast_sec = time_per_call([&] { return simd_separation(soa.view(), n, hits); }, fast);
+        print_row(n, base_sec, fast_sec, fast, base);
+    }
+
+    print_header("Projected conflicts: struct loop vs SoA kernel", "struct ms", kernel.c_str());
+
+    for (int n : sizes) {
+        std::vector<AircraftData> traffic = make_traffic(n, 320);
+        TrafficSoA soa(traffic);
+        std::vector<int> hits(n);
+        std::vector<double> times(n);
+
+        long base = 0, fast = 0;
+        double base_sec = time_per_call([&] { return all_pairs_predicted(traffic, lookahead); }, base);
+        double fast_sec = time_per_call([&] { return simd_predicted(soa.view(), n, lookahead, hits, times); }, fast);
+        print_row(n, base_sec, fast_sec, fast, base);
+    }
+}
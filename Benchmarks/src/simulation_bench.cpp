@@ -0,0 +1,119 @@
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include <pthread.h>
+#include <sys/resource.h>
+#include "bench_common.h"
+#include "../../DataTypes/simulation_engine.h"
+
+#define SIM_BENCH_TICK_SEC 0.01
+#define SIM_BENCH_WALL_SEC 1.0
+
+std::atomic<bool> legacy_running;
+std::atomic<long> legacy_locks;
+
+struct LegacySlot {
+    AirspaceMapping* airspace;
+    int slot;
+};
+
+// Same loop shape as the old Aircraft::updatePositionThread, on a faster clock
+void* legacy_position_thread(void* arg) {
+    LegacySlot* s = static_cast<LegacySlot*>(arg);
+    timespec req = {0, (long)(SIM_BENCH_TICK_SEC * 1e9)};
+
+    while (legacy_running) {
+        const AirspaceView& view = s->airspace->beginWrite();
+        AircraftData& a = view.aircraft_data[s->slot];
+        a.x += a.speedX;
+        a.y += a.speedY;
+        a.z += a.speedZ;
+        a.lastupdatedTime = time(nullptr);
+        syncHotFields(view, s->slot);
+        s->airspace->endWrite();
+        legacy_locks++;
+
+        nanosleep(&req, NULL);
+    }
+    return nullptr;
+}
+
+long context_switches() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+// Private anonymous segment with the same layout as the shared one
+AirspaceMapping* make_airspace(int count) {
+    AirspaceMapping* airspace = new AirspaceMapping();
+    if (!airspace->create(nullptr, count)) exit(EXIT_FAILURE);
+
+    std::vector<AircraftData> traffic = make_traffic(count, 320);
+    const AirspaceView& view = airspace->view();
+    for (int i = 0; i < count; i++) {
+        view.aircraft_data[i] = traffic[i];
+        syncHotFields(view, i);
+    }
+    view.header->aircraft_count = count;
+    return airspace;
+}
+
+void print_sim_row(const char* model, int threads, double ticks, long locks, long switches) {
+    std::cout << std::setw(22) << model
+              << std::setw(10) << threads
+              << std::setw(18) << std::fixed << std::setprecision(1) << locks / ticks
+              << std::setw(18) << switches / ticks << "\n";
+}
+
+void bench_simulation_engine() {
+    const int count = DEFAULT_AIRSPACE_CAPACITY;
+    const double ticks = SIM_BENCH_WALL_SEC / SIM_BENCH_TICK_SEC;
+    timespec wall = {(time_t)SIM_BENCH_WALL_SEC, 0};
+
+    std::cout << "== Position updates, " << count << " aircraft: thread per aircraft vs engine ==\n";
+    std::cout << std::left
+              << std::setw(22) << "model"
+              << std::setw(10) << "threads"
+              << std::setw(18) << "locks/sim-sec"
+              << std::setw(18) << "ctx-sw/sim-sec" << "\n";
+
+    {
+        AirspaceMapping* airspace = make_airspace(count);
+        std::vector<pthread_t> threads(count);
+        std::vector<LegacySlot> args(count);
+
+        legacy_running = true;
+        legacy_locks = 0;
+        long before = context_switches();
+        for (int i = 0; i < count; i++) {
+            args[i] = {airspace, i};
+            pthread_create(&threads[i], NULL, legacy_position_thread, &args[i]);
+        }
+        nanosleep(&wall, NULL);
+        legacy_running = false;
+        for (pthread_t t : threads) pthread_join(t, NULL);
+        long switches = context_switches() - before;
+
+        print_sim_row("thread per aircraft", count, ticks, legacy_locks, switches);
+        delete airspace;
+    }
+
+    const int pools[] = {1, 4};
+    for (int workers : pools) {
+        AirspaceMapping* airspace = make_airspace(count);
+        SimulationEngine engine(airspace, workers, SIM_BENCH_TICK_SEC);
+        for (int i = 0; i < count; i++) engine.addSlot(i);
+
+        long before = context_switches();
+        engine.start();
+        nanosleep(&wall, NULL);
+        engine.stop();
+        long switches = context_switches() - before;
+
+        print_sim_row("simulation engine", engine.threadCount(), engine.ticks(), engine.ticks(), switches);
+        delete airspace;
+    }
+}
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include "bench_common.h"
+#include "../../DataTypes/timing_logger.h"
+
+#define TIMING_BENCH_FILE "timing_bench.txt"
+#define TIMING_BENCH_SAMPLES 20000
+
+// The logger this replaces: open, append one formatted line, close
+static void legacy_log_duration(const std::string& path, const std::string& label,
+                                const timespec& start, const timespec& end) {
+    std::ofstream out(path, std::ios::app);
+    if (!out.is_open()) return;
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    out << label << " took " << std::fixed << std::setprecision(9) << elapsed << " sec\n";
+    out.close();
+}
+
+static void report(const char* name, double sec) {
+    std::cout << std::setw(32) << name
+              << std::setw(14) << std::fixed << std::setprecision(1)
+              << sec / TIMING_BENCH_SAMPLES * 1e9 << "\n";
+}
+
+// Cost of logging one duration, as paid inside the measured loop
+void bench_timing_logger() {
+    std::cout << "== Timing logger: cost of one logDuration ==\n";
+    std::cout << std::left
+              << std::setw(32) << "logger"
+              << std::setw(14) << "ns/sample" << "\n";
+
+    std::string legacy_path = "/tmp/timing/" TIMING_BENCH_FILE;
+    TimingLogger logger(TIMING_BENCH_FILE);
+    timespec a = logger.now();
+    timespec b = a;
+    b.tv_nsec += 1000;
+
+    timespec start = now_mono();
+    for (int i = 0; i < TIMING_BENCH_SAMPLES; i++) {
+        legacy_log_duration(legacy_path, "checkCurrentViolations", a, b);
+    }
+    report("open-append-close", elapsed_sec(start, now_mono()));
+
+    start = now_mono();
+    for (int i = 0; i < TIMING_BENCH_SAMPLES; i++) {
+        b.tv_nsec = 1000 + i % 5000;
+        logger.logDuration("checkCurrentViolations", a, b);
+    }
+    report("histogram", elapsed_sec(start, now_mono()));
+    std::cout << "\n";
+
+    logger.close();
+    unlink(legacy_path.c_str());
+}
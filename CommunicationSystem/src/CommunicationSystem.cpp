@@ -12,72 +12,40 @@
 #include "../../DataTypes/aircraft_data.h"
 #include "../../DataTypes/aircraft.h"
 #include "../../DataTypes/communication_system.h"
+#include "../../DataTypes/command_ring.h"
+#include "../../DataTypes/connection_cache.h"
+#include "../../DataTypes/performance_metrics.h"
+#include "../../DataTypes/termination_thread.h"
 
 using namespace std;
 
-OperatorCommandMemory* operator_cmd_mem = nullptr;
-CommunicationCommandMemory* comm_mem = nullptr;
-volatile sig_atomic_t signal_received = 0;
-pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+CommandRing* comm_ring = nullptr;
 int comm_fd;
+MetricCounter commands_delivered = metrics().counter("commandsDelivered");
+MetricCounter commands_failed = metrics().counter("commandsFailed");
+MetricCounter commands_replayed = metrics().counter("commandsReplayed");
 
-//Tutorial #3
-void signal_handler(int signo) {
-    if (signo == SIGUSR1) {
-    	pthread_cond_signal(&cond);
-    }
-}
-
-OperatorCommandMemory* init_operator_command_memory() {
-    int shm_fd;
-    struct timespec one_sec = {1, 0};  // 1 second, 0 nanoseconds
-
-    while (true) {
-        shm_fd = shm_open(OPERATOR_COMMAND_SHM_NAME, O_RDWR, 0666);
-        if (shm_fd != -1) {
-            void* addr = mmap(NULL, sizeof(OperatorCommandMemory),
-                              PROT_READ | PROT_WRITE, MAP_SHARED,
-                              shm_fd, 0);
-            if (addr != MAP_FAILED) {
-                std::cout << "[CommunicationSystem] Connected to OperatorCommand shared memory.\n";
-                close(shm_fd);
-                return static_cast<OperatorCommandMemory*>(addr);
-            } else {
-                perror("[CommunicationSystem] mmap failed for OperatorCommand");
-                close(shm_fd);
-            }
-        }
-        nanosleep(&one_sec, NULL);
-    }
-}
-
-CommunicationCommandMemory* init_communication_command_memory() {
+CommandRing* init_communication_command_ring() {
     struct timespec one_sec = {1, 0};  // 1 second, 0 nanoseconds
 
     while (true) {
         comm_fd = shm_open(COMMUNICATION_COMMAND_SHM_NAME, O_CREAT | O_RDWR, 0666);
         if (comm_fd != -1) {
-            if (ftruncate(comm_fd, sizeof(CommunicationCommandMemory)) == -1) {
+            if (ftruncate(comm_fd, sizeof(CommandRing)) == -1) {
                 perror("[CommunicationSystem] ftruncate failed");
                 exit(EXIT_FAILURE);
             }
 
-            void* addr = mmap(NULL, sizeof(CommunicationCommandMemory),
+            void* addr = mmap(NULL, sizeof(CommandRing),
                               PROT_READ | PROT_WRITE, MAP_SHARED,
                               comm_fd, 0);
             if (addr != MAP_FAILED) {
-                auto* mem = static_cast<CommunicationCommandMemory*>(addr);
-
-                pthread_mutexattr_t attr;
-                pthread_mutexattr_init(&attr);
-                pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
-                pthread_mutex_init(&mem->lock, &attr);
-                mem->command_count = 0;
+                auto* ring = static_cast<CommandRing*>(addr);
+                memset(addr, 0, sizeof(CommandRing));
+                initCommandRing(ring);
 
                 std::cout << "[CommunicationSystem] Created and initialized CommunicationCommand shared memory.\n";
-                mem->comm_pid = getpid();
-                close(comm_fd);
-                return mem;
+                return ring;
             } else {
                 perror("[CommunicationSystem] mmap failed");
                 close(comm_fd);
@@ -87,72 +55,81 @@ CommunicationCommandMemory* init_communication_command_memory() {
     }
 }
 
-// Function to send a command to a specific aircraft via IPC
-void send_command_to_aircraft(int aircraft_id, const OperatorCommand& cmd) {
+int open_aircraft_channel(int aircraft_id) {
     char service_name[20];
     snprintf(service_name, sizeof(service_name), "Aircraft%d", aircraft_id);
 
     int coid = name_open(service_name, 0);
     if (coid == -1) {
         perror("[CommunicationSystem] Failed to connect to aircraft IPC channel");
-        return;
     }
+    return coid;
+}
+
+// Repeated commands to the same aircraft skip the name server
+ConnectionCache aircraft_connections(open_aircraft_channel,
+                                     [](int coid) { name_close(coid); });
 
+// Function to send a command to a specific aircraft via IPC
+void send_command_to_aircraft(int aircraft_id, const OperatorCommand& cmd) {
     message_t msg;
     msg.aircraft_id = aircraft_id;
     msg.type = OPERATOR_TYPE;
     msg.message.operator_command = cmd;
 
-    int status = MsgSend(coid, &msg, sizeof(msg), nullptr, 0);
+    int status = aircraft_connections.send(aircraft_id, [&](int coid) {
+        return MsgSend(coid, &msg, sizeof(msg), nullptr, 0);
+    });
     if (status == -1) {
+        commands_failed.add();
         perror("[CommunicationSystem] Failed to send command to aircraft");
     } else {
+        commands_delivered.add();
         std::cout << "[CommunicationSystem] Command sent to Aircraft ID " << aircraft_id << std::endl;
     }
-
-    name_close(coid);
 }
 
-// Function to poll operator commands from shared memory and forward them to the aircraft
+// Takes each command the ComputerSystem forwarded off the ring once and
+// sends it to the aircraft
 void* pollOperatorCommands(void* arg) {
-    OperatorCommandMemory* cmd_mem = (OperatorCommandMemory*) arg;
+    CommandRing* ring = (CommandRing*) arg;
 
     std::cout << "[CommunicationSystem] Polling Operator Commands from Shared Memory...\n";
 
     while (true) {
+        uint64_t arrived = shmEventValue(&ring->not_empty);
 
-        pthread_mutex_lock(&cmd_mem->lock);
-    	// Wait for the signal to process commands
-    	pthread_cond_wait(&cond, &cmd_mem->lock);
-
-        for (int i = 0; i < cmd_mem->command_count; ++i) {
-            OperatorCommand& cmd = cmd_mem->commands[i];
-            std::cout << "[CommunicationSystem] Command sent to Aircraft ID " << cmd.aircraft_id << std::endl;
+        while (const CommandSlot* slot = peekCommand(ring)) {
+            // Copy out first: once popped, the producer may reuse the slot
+            uint64_t sequence = slot->sequence;
+            OperatorCommand cmd = slot->command;
+            popCommand(ring);
 
-            std::cout << "[Received Command] Aircraft ID: " << cmd.aircraft_id
+            std::cout << "[Received Command] #" << sequence
+                      << " Aircraft ID: " << cmd.aircraft_id
                       << " | Type: " << cmd.type
                       << " | Position: (" << cmd.position.x << ", " << cmd.position.y << ", " << cmd.position.z << ")"
                       << " | Speed: (" << cmd.speed.vx << ", " << cmd.speed.vy << ", " << cmd.speed.vz << ")"
                       << std::endl;
 
+            if (cmd.replayed) {
+                commands_replayed.add();
+                std::cout << "[CommunicationSystem] Replayed command, not delivered" << std::endl;
+                continue;
+            }
             send_command_to_aircraft(cmd.aircraft_id, cmd);
         }
 
-        cmd_mem->command_count = 0;
-
-        pthread_mutex_unlock(&cmd_mem->lock);
+        // Sleep until the ComputerSystem pushes more
+        waitShmEvent(&ring->not_empty, arrived);
     }
 
     return NULL;
 }
 
-void cleanup_shared_memory(const char* shm_name, int shm_fd, void* addr, size_t size) {
-	if (munmap(addr, size) == 0) {
-		std::cout << "Shared memory unmapped successfully." << std::endl;
-	} else {
-		perror("munmap failed");
-	}
-
+// Only removes the name. The command thread keeps reading the ring until
+// the signal ends it, so it is left for the exit to unmap.
+void unlink_shared_memory(const char* shm_name, int shm_fd) {
 	close(shm_fd);
 
 	if (shm_unlink(shm_name) == 0) {
@@ -160,38 +137,27 @@ void cleanup_shared_memory(const char* shm_name, int shm_fd, void* addr, size_t
 	} else {
 		perror("shm_unlink failed");
 	}
-
 }
 
-
+// Runs on the termination thread, not in a signal handler, so it may take
+// the connection cache's lock; the signal then ends the process as before
 void handle_termination(int signum) {
     std::cout << "[CommunicationSystem]" << signum << ", cleaning up...\n";
-    cleanup_shared_memory(COMMUNICATION_COMMAND_SHM_NAME, comm_fd, (void*) comm_mem, sizeof(CommunicationCommandMemory));
-    exit(0);
-}
-
-void setup_signal_handlers() {
-    signal(SIGINT, handle_termination);   // Ctrl+C
-    signal(SIGTERM, handle_termination);  // kill
+    aircraft_connections.clear();
+    unlink_shared_memory(COMMUNICATION_COMMAND_SHM_NAME, comm_fd);
 }
 
 using namespace std;
 
 //Communicate via open channels to each aircraft
 int main() {
-    setup_signal_handlers();
+    startTerminationThread(handle_termination);
     struct timespec one_sec = {1, 0};  // 1 second, 0 nanoseconds
 
-    if (signal(SIGUSR1, signal_handler) == SIG_ERR) {
-        perror("[CommunicationSystem] Failed to set signal handler");
-        exit(EXIT_FAILURE);
-    }
-
-    operator_cmd_mem = init_operator_command_memory();
-    comm_mem = init_communication_command_memory();
+    comm_ring = init_communication_command_ring();
 
     pthread_t command_thread;
-    pthread_create(&command_thread, NULL, pollOperatorCommands, operator_cmd_mem);
+    pthread_create(&command_thread, NULL, pollOperatorCommands, comm_ring);
 
     while (true) nanosleep(&one_sec, NULL);
 
@@ -8,30 +8,108 @@
 #include <stdbool.h>
 #include <csignal>
 #include <sys/dispatch.h>
+#include <vector>
+#include <unordered_map>
 #include "../../DataTypes/aircraft_data.h"
 #include "../../DataTypes/airspace.h"
 #include "../../DataTypes/operator_command.h"
 #include "../../DataTypes/communication_system.h"
+#include "../../DataTypes/command_ring.h"
 #include "../../DataTypes/timing_logger.h"
-
-#define FUTURE_OFFSET_SEC 120
-Airspace* airspace;
-OperatorCommandMemory* operator_cmd_mem = nullptr;
+#include "../../DataTypes/termination_thread.h"
+#include "../../DataTypes/separation.h"
+#include "../../DataTypes/spatial_grid.h"
+#include "../../DataTypes/conflict_prediction.h"
+#include "../../DataTypes/separation_simd.h"
+#include "../../DataTypes/active_index.h"
+#include "../../DataTypes/alert_ring.h"
+#include "../../DataTypes/alert_tracker.h"
+#include "../../DataTypes/display_publisher.h"
+#include "../../DataTypes/performance_metrics.h"
+
+// Live traffic is checked on this period; a lockstep replay is checked
+// once per frame instead
+#define VIOLATION_CHECK_PERIOD_SEC 5
+
+// Display snapshots follow every airspace frame, and are refreshed at
+// least this often for radar detections, which do not make a frame
+#define DISPLAY_PUBLISH_MAX_MS 500
+
+AirspaceMapping airspace;
+CommandRing* operator_cmd_ring = nullptr;
+AlertRing* alert_ring = nullptr;
+DisplaySegment* display_segment = nullptr;
 bool operator_cmd_initialized = false;
-bool commands_available = false;
 TimingLogger logger("violation_check.txt");
+MetricCounter commands_forwarded = metrics().counter("commandsForwarded");
+MetricCounter alerts_sent = metrics().counter("alertsSent");
+MetricCounter alerts_dropped = metrics().counter("alertsDropped");
+MetricGauge display_tracks = metrics().gauge("displayTracks");
+SpatialGrid current_grid;
+
+// Local SoA copy of the active aircraft, compacted so the kernels see no gaps
+struct HotSnapshot {
+    std::vector<double> x, y, z, vx, vy, vz;
+    std::vector<uint8_t> active;
+    std::vector<int> id;
+    std::unordered_map<int, int> index;     // aircraft id -> position
+
+    void clear() {
+        x.clear(); y.clear(); z.clear();
+        vx.clear(); vy.clear(); vz.clear();
+        active.clear(); id.clear();
+        index.clear();
+    }
+
+    void push(const AirspaceView& hot, int i, int aircraft_id) {
+        x.push_back(hot.x[i]); y.push_back(hot.y[i]); z.push_back(hot.z[i]);
+        vx.push_back(hot.vx[i]); vy.push_back(hot.vy[i]); vz.push_back(hot.vz[i]);
+        active.push_back(1);
+        index[aircraft_id] = id.size();
+        id.push_back(aircraft_id);
+    }
+
+    int find(int aircraft_id) const {
+        auto it = index.find(aircraft_id);
+        return it == index.end() ? -1 : it->second;
+    }
+
+    SoAView view() const {
+        return {x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data(), active.data()};
+    }
+};
+
+// Copies the active aircraft without taking the airspace lock, so a long
+// check never holds up the position updates
+void takeHotSnapshot(AirspaceMapping* l_airspace, HotSnapshot& snapshot) {
+    l_airspace->read([&](const AirspaceView& view) {
+        snapshot.clear();
+        forEachActiveSlot(view, [&](int i) {
+            snapshot.push(view, i, view.aircraft_data[i].id);
+        });
+    });
+}
+
+HotSnapshot current_snapshot;
+HotSnapshot future_snapshot;
+std::vector<int> future_hits;
+std::vector<double> future_times;
+double lookahead_sec = DEFAULT_LOOKAHEAD_SEC;
+AlertTracker current_alerts;
+AlertTracker future_alerts;
 
-int comm_system_pid = -1;
 int operator_cmd_fd;
+int alert_ring_fd;
+int display_fd;
 
 struct ViolationArgs {
-    Airspace* shm_ptr;
-    int total_aircraft;
+    AirspaceMapping* shm_ptr;
     double elapsedTime;
+    double lookahead_sec;
 };
 
 
-OperatorCommandMemory* init_operator_command_memory() {
+CommandRing* init_operator_command_ring() {
 
     operator_cmd_fd = shm_open(OPERATOR_COMMAND_SHM_NAME, O_CREAT | O_RDWR, 0666);
     if (operator_cmd_fd == -1) {
@@ -39,206 +117,264 @@ OperatorCommandMemory* init_operator_command_memory() {
         exit(EXIT_FAILURE);
     }
 
-    if (ftruncate(operator_cmd_fd, sizeof(OperatorCommandMemory)) == -1) {
+    if (ftruncate(operator_cmd_fd, sizeof(CommandRing)) == -1) {
         perror("ftruncate failed for operator commands");
         exit(EXIT_FAILURE);
     }
 
-    void* addr = mmap(NULL, sizeof(OperatorCommandMemory), PROT_READ | PROT_WRITE, MAP_SHARED, operator_cmd_fd, 0);
+    void* addr = mmap(NULL, sizeof(CommandRing), PROT_READ | PROT_WRITE, MAP_SHARED, operator_cmd_fd, 0);
     if (addr == MAP_FAILED) {
         perror("mmap failed for operator commands");
         exit(EXIT_FAILURE);
     }
 
-    OperatorCommandMemory* cmd_mem = static_cast<OperatorCommandMemory*>(addr);
-
-    pthread_mutexattr_t attr;
-    pthread_mutexattr_init(&attr);
-    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
-    pthread_mutex_init(&cmd_mem->lock, &attr);
-    cmd_mem->command_count = 0;
+    CommandRing* ring = static_cast<CommandRing*>(addr);
+    memset(addr, 0, sizeof(CommandRing));
+    initCommandRing(ring);
 
     operator_cmd_initialized = true;
 
     std::cout << "[ComputerSystem] Initialized OperatorCommand shared memory\n";
-    return cmd_mem;
+    return ring;
 }
 
-void* pollOperatorCommands(void* arg) {
-    OperatorCommandMemory* cmd_mem = (OperatorCommandMemory*) arg;
-
-    std::cout << "[ComputerSystem] Polling Operator Commands...\n";
-
-    int comm_fd;
-    void* addr = MAP_FAILED;
+CommandRing* connect_to_communication_ring() {
     struct timespec wait_time = {1, 0};  // 1 second
 
     std::cout << "[ComputerSystem] Waiting for CommunicationCommand shared memory to become available...\n";
 
     while (1) {
-        comm_fd = shm_open(COMMUNICATION_COMMAND_SHM_NAME, O_RDWR, 0666);
+        int comm_fd = shm_open(COMMUNICATION_COMMAND_SHM_NAME, O_RDWR, 0666);
         if (comm_fd != -1) {
-            addr = mmap(NULL, sizeof(CommunicationCommandMemory), PROT_READ | PROT_WRITE, MAP_SHARED, comm_fd, 0);
+            void* addr = mmap(NULL, sizeof(CommandRing), PROT_READ | PROT_WRITE, MAP_SHARED, comm_fd, 0);
+            close(comm_fd);
             if (addr != MAP_FAILED) {
-                std::cout << "[ComputerSystem] Successfully connected to CommunicationCommand shared memory\n";
-                close(comm_fd);
-                break;
+                CommandRing* ring = static_cast<CommandRing*>(addr);
+                // The CommunicationSystem sets the magic once the ring is ready
+                if (ring->magic == COMMAND_RING_MAGIC) {
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    std::cout << "[ComputerSystem] Successfully connected to CommunicationCommand shared memory\n";
+                    return ring;
+                }
+                munmap(addr, sizeof(CommandRing));
             } else {
                 perror("[ComputerSystem] mmap failed for CommunicationCommand shared memory");
-                close(comm_fd);
             }
         }
         nanosleep(&wait_time, NULL);
-
     }
+}
 
-    CommunicationCommandMemory* comm_mem = static_cast<CommunicationCommandMemory*>(addr);
-    comm_system_pid = comm_mem->comm_pid;
-    std::cout << "[ComputerSystem] Retrieved CommunicationSystem PID: " << comm_system_pid << "\n";
+// Moves each operator command onto the CommunicationSystem's ring exactly
+// once. A command is only taken off the operator ring after it has been
+// queued downstream, so a full downstream ring just delays it. Sleeps on
+// the ring events in between, never on a timer.
+void* pollOperatorCommands(void* arg) {
+    CommandRing* cmd_ring = (CommandRing*) arg;
+
+    std::cout << "[ComputerSystem] Polling Operator Commands...\n";
+
+    CommandRing* comm_ring = connect_to_communication_ring();
 
     while (true) {
-        pthread_mutex_lock(&cmd_mem->lock);
+        uint64_t arrived = shmEventValue(&cmd_ring->not_empty);
+        uint64_t drained = shmEventValue(&comm_ring->not_full);
+        bool blocked = false;
 
-        for (int i = 0; i < cmd_mem->command_count; ++i) {
-            OperatorCommand& cmd = cmd_mem->commands[i];
+        while (const CommandSlot* slot = peekCommand(cmd_ring)) {
+            const OperatorCommand& cmd = slot->command;
+
+            if (!pushCommand(comm_ring, cmd)) {
+                std::cerr << "[ComputerSystem] CommunicationCommand ring full, holding "
+                          << pendingCommands(cmd_ring) << " command(s)\n";
+                blocked = true;
+                break;
+            }
 
-            std::cout << "[Received Command] Aircraft ID: " << cmd.aircraft_id
+            commands_forwarded.add();
+            std::cout << "[Received Command] #" << slot->sequence
+                      << " Aircraft ID: " << cmd.aircraft_id
                       << " | Type: " << cmd.type
                       << " | Position: (" << cmd.position.x << ", " << cmd.position.y << ", " << cmd.position.z << ")"
                       << " | Speed: (" << cmd.speed.vx << ", " << cmd.speed.vy << ", " << cmd.speed.vz << ")"
                       << std::endl;
 
-            pthread_mutex_lock(&comm_mem->lock);
-            comm_mem->commands[comm_mem->command_count] = cmd;
-            printf("[CommunicationSystem] Command stored: Aircraft ID: %d | Type: %d | Position: (%.2f, %.2f, %.2f) | Speed: (%.2f, %.2f, %.2f)\n",
-                   cmd.aircraft_id,
-                   cmd.type,
-                   cmd.position.x, cmd.position.y, cmd.position.z,
-                   cmd.speed.vx, cmd.speed.vy, cmd.speed.vz);
-
-            comm_mem->command_count+=1;
-            pthread_mutex_unlock(&comm_mem->lock);
-
-            // Set commands_available to true after storing the command
-            commands_available = true;
+            popCommand(cmd_ring);
         }
 
-        if (commands_available && comm_system_pid > 0) {
-            std::cout << "[ComputerSystem] Sending SIGUSR1 to PID " << comm_system_pid << "...\n";
-
+        if (blocked) {
+            waitShmEvent(&comm_ring->not_full, drained);
+        } else {
+            waitShmEvent(&cmd_ring->not_empty, arrived);
         }
-
-        if (kill(comm_system_pid, SIGUSR1) == -1) {
-			 perror("[ComputerSystem] Error sending SIGUSR1");
-		}
-
-        pthread_mutex_unlock(&cmd_mem->lock);
-
-        nanosleep(&wait_time, NULL);
-
     }
 
-    cmd_mem->command_count = 0;
-    commands_available = false;
-
-
     return NULL;
 }
 
 
-Airspace* init_airspace_shared_memory() {
-    int shm_fd;
-    void* addr = MAP_FAILED;
+void init_airspace_shared_memory() {
     struct timespec wait_time = {1, 0};  // 1 second
 
     printf("[ComputerSystem] Waiting for Airspace shared memory to become available...\n");
 
-    while (1) {
-        shm_fd = shm_open(AIRSPACE_SHM_NAME, O_RDWR, 0666);
-        if (shm_fd != -1) {
-            addr = mmap(NULL, sizeof(Airspace), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
-            if (addr != MAP_FAILED) {
-                printf("[ComputerSystem] Successfully connected to Airspace shared memory\n");
-                close(shm_fd);
-                return (Airspace*)addr;
-            } else {
-                perror("[Airspace] mmap failed");
-                close(shm_fd);
-            }
-        }
-
+    while (!airspace.attach(AIRSPACE_SHM_NAME, true)) {
         nanosleep(&wait_time, NULL);
-
     }
+    printf("[ComputerSystem] Successfully connected to Airspace shared memory\n");
 }
 
 
 
 
-void sendAlert(int aircraft1, int aircraft2) {
-    char message[100];
-    snprintf(message, sizeof(message),
-             "ALERT: Aircraft %d and Aircraft %d are too close!", aircraft1, aircraft2);
+AlertRing* init_alert_ring() {
 
-    int coid = name_open(OPERATOR_VIOLATIONS_CHANNEL_NAME, 0);
-    if (coid == -1) {
-        perror("[ComputerSystem] Failed to connect to OperatorConsole IPC channel");
-        return;
+    alert_ring_fd = shm_open(ALERT_RING_SHM_NAME, O_CREAT | O_RDWR, 0666);
+    if (alert_ring_fd == -1) {
+        perror("shm_open failed for alert ring");
+        exit(EXIT_FAILURE);
     }
 
-    int status = MsgSend(coid, message, sizeof(message), NULL, 0);
-    if (status == -1) {
-        perror("[ComputerSystem] Failed to send alert to OperatorConsole");
-    } else {
-    	//TURN ON ALERTS
-        //std::cout << "[ComputerSystem] Alert sent to OperatorConsole: " << message << std::endl;
+    if (ftruncate(alert_ring_fd, sizeof(AlertRing)) == -1) {
+        perror("ftruncate failed for alert ring");
+        exit(EXIT_FAILURE);
     }
 
-    name_close(coid);
-}
+    void* addr = mmap(NULL, sizeof(AlertRing), PROT_READ | PROT_WRITE, MAP_SHARED, alert_ring_fd, 0);
+    if (addr == MAP_FAILED) {
+        perror("mmap failed for alert ring");
+        exit(EXIT_FAILURE);
+    }
 
-void getProjectedPosition(AircraftData& aircraft, double time) {
-    aircraft.x += aircraft.speedX * time / 3600;
-    aircraft.y += aircraft.speedY * time / 3600;
-    aircraft.z += aircraft.speedZ * time / 3600;
+    AlertRing* ring = static_cast<AlertRing*>(addr);
+    memset(addr, 0, sizeof(AlertRing));
+    initAlertRing(ring);
+
+    std::cout << "[ComputerSystem] Initialized alert ring shared memory\n";
+    return ring;
 }
 
-void* checkCurrentViolations(void* args) {
-	timespec start = logger.now();
-    struct ViolationArgs* data = (struct ViolationArgs*) args;
-    Airspace* l_airspace = data->shm_ptr;
+DisplaySegment* init_display_segment() {
 
-    int max = data->total_aircraft;
+    display_fd = shm_open(DISPLAY_SHM_NAME, O_CREAT | O_RDWR, 0666);
+    if (display_fd == -1) {
+        perror("shm_open failed for display snapshots");
+        exit(EXIT_FAILURE);
+    }
 
-    time_t now = time(NULL);
+    if (ftruncate(display_fd, sizeof(DisplaySegment)) == -1) {
+        perror("ftruncate failed for display snapshots");
+        exit(EXIT_FAILURE);
+    }
+
+    void* addr = mmap(NULL, sizeof(DisplaySegment), PROT_READ | PROT_WRITE, MAP_SHARED, display_fd, 0);
+    if (addr == MAP_FAILED) {
+        perror("mmap failed for display snapshots");
+        exit(EXIT_FAILURE);
+    }
 
-    pthread_mutex_lock(&airspace->lock);
+    DisplaySegment* segment = static_cast<DisplaySegment*>(addr);
+    memset(addr, 0, sizeof(DisplaySegment));
+    initDisplaySegment(segment);
 
-    for (int i = 0; i < max; i++) {
-        AircraftData* a1 = &l_airspace->aircraft_data[i];
-        if (a1->id == 0 || now < a1->entryTime) continue;
+    std::cout << "[ComputerSystem] Initialized display snapshot shared memory\n";
+    return segment;
+}
 
-        for (int j = i + 1; j < max; j++) {
-            AircraftData* a2 = &l_airspace->aircraft_data[j];
-            if (a2->id == 0 || now < a2->entryTime) continue;
+// Works out the displays' picture once per airspace frame, however many
+// displays read it
+void* publishDisplaySnapshots(void* arg) {
+    DisplayPublisher publisher(static_cast<DisplaySegment*>(arg));
+    Airspace* h = airspace.header();
 
-            double dx = fabs(a1->x - a2->x);
-            double dy = fabs(a1->y - a2->y);
-            double dz = fabs(a1->z - a2->z);
-            double horizontal = sqrt(dx * dx + dy * dy);
+    while (true) {
+        // Read the event first, so a frame published meanwhile is not missed
+        uint64_t seen = shmEventValue(&h->frame_ready);
 
-//            std::cout << "[ComputerSystem] Comparing Aircraft " << a1->id << " and " << a2->id << "\n"
-//                                  << "    A1 Pos: (" << a1->x << ", " << a1->y << ", " << a1->z << ")\n"
-//                                  << "    A2 Pos: (" << a2->x << ", " << a2->y << ", " << a2->z << ")\n"
-//                                  << "    Horizontal: " << horizontal << "m, Vertical (Z): " << dz << "m\n";
+        timespec start = logger.now();
+        display_tracks.set(publisher.publish(airspace));
+        timespec end = logger.now();
+        logger.logDuration("publishDisplaySnapshot", start, end);
 
-            if (horizontal < 3000 || dz < 1000) {
-                sendAlert(a1->id, a2->id);
-            }
-        }
+        waitShmEvent(&h->frame_ready, seen, DISPLAY_PUBLISH_MAX_MS);
     }
+    return NULL;
+}
+
+// Never blocks the checker: a full ring drops the alert and counts it
+void sendAlert(int aircraft1, int aircraft2, double dx, double dy, double dz, AlertState state) {
+    AlertRecord record;
+    record.timestamp = time(NULL);
+    record.aircraft1 = aircraft1;
+    record.aircraft2 = aircraft2;
+    record.kind = ALERT_LOSS_OF_SEPARATION;
+    record.state = state;
+    record.severity = alertSeverity(ALERT_LOSS_OF_SEPARATION, 0);
+    record.horizontal = std::sqrt(dx * dx + dy * dy);
+    record.vertical = std::fabs(dz);
+    record.time_to_conflict = 0;
+    if (pushAlert(alert_ring, record)) alerts_sent.add();
+    else alerts_dropped.add();
+}
+
+void sendPredictedAlert(int aircraft1, int aircraft2, const ConflictPrediction& prediction,
+                        AlertState state) {
+    AlertRecord record;
+    record.timestamp = time(NULL);
+    record.aircraft1 = aircraft1;
+    record.aircraft2 = aircraft2;
+    record.kind = ALERT_PREDICTED_CONFLICT;
+    record.state = state;
+    record.severity = alertSeverity(ALERT_PREDICTED_CONFLICT, prediction.time_to_los);
+    record.horizontal = prediction.dcpa;
+    record.vertical = prediction.dz_at_cpa;
+    record.time_to_conflict = prediction.time_to_los;
+    if (pushAlert(alert_ring, record)) alerts_sent.add();
+    else alerts_dropped.add();
+}
+
+void* checkCurrentViolations(void* args) {
+	timespec start = logger.now();
+    struct ViolationArgs* data = (struct ViolationArgs*) args;
+    AirspaceMapping* l_airspace = data->shm_ptr;
+
+    takeHotSnapshot(l_airspace, current_snapshot);
+    const HotSnapshot& snap = current_snapshot;
+    current_alerts.beginCycle();
+
+    // Only aircraft in neighbouring grid cells can be closer than the minima
+    current_grid.rebuild(snap.view(), snap.id.size());
+    current_grid.forEachCandidatePair([&](int i, int j) {
+        double dx = snap.x[i] - snap.x[j];
+        double dy = snap.y[i] - snap.y[j];
+        double dz = snap.z[i] - snap.z[j];
+
+        if (isLossOfSeparation(dx, dy, dz) &&
+            current_alerts.observe(snap.id[i], snap.id[j]) == ALERT_NEW) {
+            sendAlert(snap.id[i], snap.id[j], dx, dy, dz, ALERT_NEW);
+        }
+    });
+
+    // Pairs that were in conflict but are not any more: resolved once they
+    // are clear of the minima by the hysteresis margins, or have left
+    double dx, dy, dz;
+    current_alerts.endCycle([&](int a, int b) {
+        int i = snap.find(a), j = snap.find(b);
+        if (i < 0 || j < 0) {
+            dx = dy = dz = 0;
+            return false;
+        }
+        dx = snap.x[i] - snap.x[j];
+        dy = snap.y[i] - snap.y[j];
+        dz = snap.z[i] - snap.z[j];
+        double limit = HORIZONTAL_SEPARATION + HORIZONTAL_HYSTERESIS;
+        return dx * dx + dy * dy < limit * limit &&
+               std::fabs(dz) < VERTICAL_SEPARATION + VERTICAL_HYSTERESIS;
+    }, [&](int a, int b) {
+        sendAlert(a, b, dx, dy, dz, ALERT_RESOLVED);
+    });
+    alert_ring->suppressed.fetch_add(current_alerts.takeSuppressed(), std::memory_order_relaxed);
 
-    pthread_mutex_unlock(&airspace->lock);
     timespec end = logger.now();
     logger.logDuration("checkCurrentViolations", start, end);
 
@@ -249,66 +385,95 @@ void* checkCurrentViolations(void* args) {
 void* checkFutureViolations(void* args) {
 	timespec start = logger.now();
     struct ViolationArgs* data = (struct ViolationArgs*) args;
-    Airspace* l_airspace = data->shm_ptr;
-    int max = data->total_aircraft;
-
-    time_t now = time(NULL);
-
-    pthread_mutex_lock(&airspace->lock);
+    AirspaceMapping* l_airspace = data->shm_ptr;
 
-    for (int i = 0; i < max; i++) {
-        AircraftData* a1 = &l_airspace->aircraft_data[i];
+    // Copy the hot fields of the active aircraft once; prediction never
+    // writes to shared memory
+    takeHotSnapshot(l_airspace, future_snapshot);
 
-        if (a1->id == 0 || now < a1->entryTime) continue;
+    int count = future_snapshot.id.size();
+    SoAView view = future_snapshot.view();
+    future_hits.resize(count);
+    future_times.resize(count);
+    future_alerts.beginCycle();
 
-        for (int j = i + 1; j < max; j++) {
-            AircraftData* a2 = &l_airspace->aircraft_data[j];
-            if (a2->id == 0 || now < a2->entryTime) continue;
+    for (int i = 0; i < count; i++) {
+        // Tests aircraft i against several later aircraft per instruction
+        int found = conflictRow(view, i, i + 1, count, data->lookahead_sec,
+                                future_hits.data(), future_times.data());
 
-            // Project both aircraft 2 minutes ahead
-            a1->x += a1->speedX * FUTURE_OFFSET_SEC / 3600;
-            a1->y += a1->speedY * FUTURE_OFFSET_SEC / 3600;
-            a1->z += a1->speedZ * FUTURE_OFFSET_SEC / 3600;
+        for (int k = 0; k < found; k++) {
+            int j = future_hits[k];
+            if (future_alerts.observe(future_snapshot.id[i], future_snapshot.id[j]) != ALERT_NEW) continue;
 
-            a2->x += a2->speedX * FUTURE_OFFSET_SEC / 3600;
-            a2->y += a2->speedY * FUTURE_OFFSET_SEC / 3600;
-            a2->z += a2->speedZ * FUTURE_OFFSET_SEC / 3600;
-
-            double dx = fabs(a1->x - a2->x);
-            double dy = fabs(a1->y - a2->y);
-            double dz = fabs(a1->z - a2->z);
-            double horizontal = sqrt(dx * dx + dy * dy);
-
-//            std::cout << "[ComputerSystem] Comparing Aircraft " << a1->id << " and " << a2->id << "\n"
-//                      << "    A1 Pos: (" << a1->x << ", " << a1->y << ", " << a1->z << ")\n"
-//                      << "    A2 Pos: (" << a2->x << ", " << a2->y << ", " << a2->z << ")\n"
-//                      << "    Horizontal: " << horizontal << "m, Vertical (Z): " << dz << "m\n";
-
-
-            if (horizontal < 3000 || dz < 1000) {
-                sendAlert(a1->id, a2->id);
-            }
+            ConflictPrediction prediction = predictConflict(view, i, j, data->lookahead_sec);
+            sendPredictedAlert(future_snapshot.id[i], future_snapshot.id[j], prediction, ALERT_NEW);
         }
     }
 
-    pthread_mutex_unlock(&airspace->lock);
-    //usleep(5000); -- debug to see if timing is accounted for in logger
+    // A predicted pair stays open while it still conflicts within a
+    // slightly longer window, which covers pairs already in loss of
+    // separation too (those belong to the current check meanwhile)
+    ConflictPrediction last = {};
+    future_alerts.endCycle([&](int a, int b) {
+        int i = future_snapshot.find(a), j = future_snapshot.find(b);
+        if (i < 0 || j < 0) {
+            last = {};
+            last.time_to_los = -1;
+            return false;
+        }
+        last = predictConflict(view, i, j, data->lookahead_sec + PREDICTION_HYSTERESIS_SEC);
+        return last.time_to_los >= 0;
+    }, [&](int a, int b) {
+        sendPredictedAlert(a, b, last, ALERT_RESOLVED);
+    });
+    alert_ring->suppressed.fetch_add(future_alerts.takeSuppressed(), std::memory_order_relaxed);
+
     timespec end = logger.now();
     logger.logDuration("checkFuturetViolations", start, end);
     return NULL;
 }
 
 
-void* violationCheck(void* arg) {
+// Waits out the live check period, cut short as soon as a replay asks
+// for lockstep
+void wait_for_next_check(Airspace* h, uint64_t seen) {
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += VIOLATION_CHECK_PERIOD_SEC;
+
+    while (!h->lockstep.load(std::memory_order_acquire)) {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long left_ms = (deadline.tv_sec - now.tv_sec) * 1000L +
+                       (deadline.tv_nsec - now.tv_nsec) / 1000000L;
+        if (left_ms <= 0) return;
+        seen = waitShmEvent(&h->frame_ready, seen, left_ms);
+    }
+}
 
-    struct timespec ts = {5, 0};
+void* violationCheck(void* arg) {
 
     std::cout << "[ComputerSystem] Checking Violations...\n";
 
+    Airspace* h = airspace.header();
+    uint64_t acknowledged = 0;
+
     while (1) {
+        // Read the event before the frame, so a frame published during the
+        // check still ends the wait below
+        uint64_t seen = shmEventValue(&h->frame_ready);
+        uint64_t frame = h->frame.load(std::memory_order_acquire);
+
+        // In lockstep every frame is checked exactly once
+        if (h->lockstep.load(std::memory_order_acquire) && frame == acknowledged) {
+            waitShmEvent(&h->frame_ready, seen, VIOLATION_CHECK_PERIOD_SEC * 1000L);
+            continue;
+        }
+
         struct ViolationArgs args = {
-            .shm_ptr = airspace,
-            .total_aircraft = MAX_AIRCRAFT,
+            .shm_ptr = &airspace,
+            .lookahead_sec = lookahead_sec,
         };
 
         pthread_t currentThread, futureThread;
@@ -319,61 +484,73 @@ void* violationCheck(void* arg) {
         pthread_join(currentThread, NULL);
         pthread_join(futureThread, NULL);
 
-
-        nanosleep(&ts, NULL);
+        if (h->lockstep.load(std::memory_order_acquire)) {
+            // The replay holds the next frame until this one is reported
+            h->checked_frame.store(frame, std::memory_order_release);
+            signalShmEvent(&h->frame_checked);
+            acknowledged = frame;
+            waitShmEvent(&h->frame_ready, seen, VIOLATION_CHECK_PERIOD_SEC * 1000L);
+        } else {
+            wait_for_next_check(h, seen);
+        }
     }
 
     return NULL;
 }
 
-void cleanup_shared_memory(const char* shm_name, int shm_fd, void* addr,
-						   size_t size) {
-	if (munmap(addr, size) == 0) {
-		std::cout << "Shared memory unmapped successfully." << std::endl;
-	} else {
-		perror("munmap failed");
-	}
-
+// Only removes the name. The publisher, the checkers and the command
+// thread keep using the mapping until the signal ends them, so it is left
+// for the exit to unmap.
+void unlink_shared_memory(const char* shm_name, int shm_fd) {
 	close(shm_fd);
-
-	if (operator_cmd_initialized == true){
-		if (shm_unlink(shm_name) == 0) {
-				std::cout << "Shared memory unlinked successfully." << std::endl;
-		} else {
-			perror("shm_unlink failed");
-		}
+	if (shm_unlink(shm_name) == 0) {
+		std::cout << "Shared memory unlinked successfully." << std::endl;
+	} else {
+		perror("shm_unlink failed");
 	}
-
 }
 
-void handle_termination(int signum) {
+// Runs on the termination thread, not in a signal handler; the signal
+// then ends the process as before
+void handle_termination(int) {
     std::cout << "[ComputerSystem]" << " cleaning up operator shared memory...\n";
-    cleanup_shared_memory(OPERATOR_COMMAND_SHM_NAME, operator_cmd_fd, (void*) operator_cmd_mem, sizeof(OperatorCommandMemory));
-    exit(0);
+    if (operator_cmd_initialized) {
+        unlink_shared_memory(OPERATOR_COMMAND_SHM_NAME, operator_cmd_fd);
+    }
+    unlink_shared_memory(ALERT_RING_SHM_NAME, alert_ring_fd);
+    unlink_shared_memory(DISPLAY_SHM_NAME, display_fd);
+    logger.close();
 }
 
-void setup_signal_handlers() {
-    signal(SIGINT, handle_termination);   // Ctrl+C
-    signal(SIGTERM, handle_termination);  // kill
-}
+int main(int argc, char* argv[]) {
 
-int main() {
+    // Optional argument: conflict prediction window in seconds
+    if (argc > 1) {
+        lookahead_sec = atof(argv[1]);
+    }
 
-	setup_signal_handlers();
-    airspace = init_airspace_shared_memory();
-    operator_cmd_mem = init_operator_command_memory();
+    startTerminationThread(handle_termination);
+    init_airspace_shared_memory();
+    operator_cmd_ring = init_operator_command_ring();
+    alert_ring = init_alert_ring();
+    display_segment = init_display_segment();
 
     pthread_t monitorThread;
     pthread_create(&monitorThread, NULL, violationCheck, NULL);
 
     pthread_t cmdThread;
-    pthread_create(&cmdThread, NULL, pollOperatorCommands, operator_cmd_mem);
+    pthread_create(&cmdThread, NULL, pollOperatorCommands, operator_cmd_ring);
+
+    pthread_t displayThread;
+    pthread_create(&displayThread, NULL, publishDisplaySnapshots, display_segment);
 
     struct timespec sleep_forever = {10, 0};
     while (true) nanosleep(&sleep_forever, NULL);
 
-    munmap(airspace, sizeof(Airspace));
-    munmap(operator_cmd_mem, sizeof(OperatorCommandMemory));
+    airspace.close(false);
+    munmap(operator_cmd_ring, sizeof(CommandRing));
+    munmap(alert_ring, sizeof(AlertRing));
+    munmap(display_segment, sizeof(DisplaySegment));
 
     return 0;
 }
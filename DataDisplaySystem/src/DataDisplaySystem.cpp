@@ -3,6 +3,7 @@
 #include <sys/mman.h>
 #include <sys/dispatch.h>
 #include <unistd.h>
+#include <csignal>
 #include <ctime>
 #include <vector>
 #include <cstring>
@@ -11,49 +12,61 @@
 #include <cstring>
 #include <sstream>
 #include <map>
+#include <algorithm>
+#include <atomic>
 #include "../../DataTypes/aircraft_data.h"
-#include "../../DataTypes/airspace.h"
 #include "../../DataTypes/operator_command.h"
 #include "../../DataTypes/timing_logger.h"
-
-#define AIRSPACE_WIDTH 100000
-#define AIRSPACE_HEIGHT 100000
-#define DISPLAY_WIDTH 50
-#define DISPLAY_HEIGHT 14
-
-Airspace* airspace = nullptr;
-std::map<int, char> blipMap;
+#include "../../DataTypes/airspace_display.h"
+#include "../../DataTypes/terminal_renderer.h"
+#include "../../DataTypes/display_viewport.h"
+#include "../../DataTypes/display_data.h"
+#include "../../DataTypes/display_client.h"
+#include "../../DataTypes/termination_thread.h"
+
+#define DEFAULT_REFRESH_HZ 1
+#define MAX_REFRESH_HZ 30
+#define HEADLESS_REPORT_SEC 10
+
+DisplaySegment* snapshots = nullptr;
 int operator_coid = -1;
 TimingLogger logger("draw_display.txt");
-
-void clearScreen() {
-    for (int i = 0; i < 24; ++i)
-        std::cout << '\n';
-}
-
+TerminalRenderer renderer;
+DisplayFrame frame;
+Viewport viewport;
+pthread_mutex_t viewport_mutex = PTHREAD_MUTEX_INITIALIZER;
+bool on_terminal = false;
+bool headless = false;
+DisplayClient* client = nullptr;
+volatile sig_atomic_t resized = 0;
+
+// The ComputerSystem publishes the display snapshots
 void connectToSharedMemory() {
-    std::cout << "[DataDisplaySystem] Waiting for Airspace shared memory to be created...\n";
+    std::cout << "[DataDisplaySystem] Waiting for display snapshot shared memory to be created...\n";
     struct timespec wait_time = {1, 0};
 
     while (true) {
-        int shm_fd = shm_open(AIRSPACE_SHM_NAME, O_RDONLY, 0666);
-        if (shm_fd == -1) {
-        	nanosleep(&wait_time, NULL);
-            continue;
-        }
-
-        void* addr = mmap(nullptr, sizeof(Airspace), PROT_READ, MAP_SHARED, shm_fd, 0);
-        if (addr == MAP_FAILED) {
+        int shm_fd = shm_open(DISPLAY_SHM_NAME, O_RDWR, 0666);
+        if (shm_fd != -1) {
+            void* addr = mmap(NULL, sizeof(DisplaySegment), PROT_READ | PROT_WRITE,
+                              MAP_SHARED, shm_fd, 0);
             close(shm_fd);
-            nanosleep(&wait_time, NULL);
-            continue;
+            if (addr != MAP_FAILED) {
+                DisplaySegment* segment = static_cast<DisplaySegment*>(addr);
+                if (segment->magic == DISPLAY_MAGIC &&
+                    segment->layout_version == DISPLAY_LAYOUT_VERSION) {
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    snapshots = segment;
+                    break;
+                }
+                munmap(addr, sizeof(DisplaySegment));
+            } else {
+                perror("[DataDisplaySystem] mmap failed for display snapshots");
+            }
         }
-
-        airspace = static_cast<Airspace*>(addr);
-        std::cout << "[DataDisplaySystem] Shared memory successfully mapped\n";
-        close(shm_fd);
-        break;
+        nanosleep(&wait_time, NULL);
     }
+    std::cout << "[DataDisplaySystem] Shared memory successfully mapped\n";
 }
 
 
@@ -70,117 +83,54 @@ char getDirectionArrow(float vx, float vy) {
 }
 
 void drawAirspace() {
-    char screen[DISPLAY_HEIGHT][DISPLAY_WIDTH];
-    memset(screen, '.', sizeof(screen));
-    std::vector<AircraftData> activeAircrafts;
-
-    activeAircrafts.clear();
-
-    for (int i = 0; i < airspace->aircraft_count; ++i) {
-        AircraftData& aircraft = airspace->aircraft_data[i];
-
-        if (!aircraft.detected) continue;
-        if (aircraft.z < 15000 || aircraft.z > 25000) continue;
-
-        int x = static_cast<int>((aircraft.x / AIRSPACE_WIDTH) * DISPLAY_WIDTH);
-        int y = static_cast<int>((aircraft.y / AIRSPACE_HEIGHT) * DISPLAY_HEIGHT);
-
-        if (x == 0) x = 1;
-        if (y < 1) y = 2;
-
-        if (x >= 0 && x < DISPLAY_WIDTH && y >= 1 && y < DISPLAY_HEIGHT) {
-            activeAircrafts.push_back(aircraft);
-
-            // Assign BLIP symbol if new
-            if (blipMap.find(aircraft.id) == blipMap.end()) {
-                blipMap[aircraft.id] = 'a' + i;
-            }
-
-            if (screen[y][x] == '.') {
-                screen[y][x] = blipMap[aircraft.id];
-            } else {
-                screen[y][x] = '+';
-            }
+    pthread_mutex_lock(&viewport_mutex);
+    Viewport view_now = viewport;
+    pthread_mutex_unlock(&viewport_mutex);
+    client->setFilter(view_now);
+
+    // The snapshot already holds the blips, table rows and whole-airspace
+    // grid; a zoomed view only visits the tiles in view
+    timespec start = logger.now();
+    int64_t latency_ns = client->render(frame);
+    timespec end = logger.now();
+    logger.logDuration("drawAirspace", start, end);
+
+    // How long the picture took to get here from the ComputerSystem
+    if (latency_ns >= 0) {
+        timespec published = end;
+        published.tv_sec -= latency_ns / 1000000000;
+        published.tv_nsec -= latency_ns % 1000000000;
+        if (published.tv_nsec < 0) {
+            published.tv_sec--;
+            published.tv_nsec += 1000000000;
         }
+        logger.logDuration("publishToFrame", published, end);
     }
+    if (headless) return;
+
+    // On a terminal only the changed cells are redrawn; redirected output
+    // gets every frame in full, one after another
+    if (on_terminal) {
+        renderer.render(frame);
+    } else {
+        for (int row = 0; row < FRAME_ROWS; ++row) {
+            std::cout.write(frame.cells[row], FRAME_COLUMNS) << '\n';
+        }
+        std::cout << std::flush;
+    }
+}
 
-
-    // Draw Top Border
-       for (int col = 0; col < (DISPLAY_WIDTH * 2) + 31; ++col) std::cout << "=";
-       std::cout << "===\n";
-
-       std::cout << "|" << std::setw(DISPLAY_WIDTH) << std::left << " AIRSPACE ";
-       std::cout << "||   "
-          << std::setw(8) << std::left << "BLIP"
-		  << std::setw(8) << "ID"
-          << std::setw(8) << "X"
-          << std::setw(8) << "Y"
-          << std::setw(8) << "Z"
-          << std::setw(6) << "VX"
-          << std::setw(6) << "VY"
-          << std::setw(4) << "VZ"
-		  << std::setw(10) << "Entry"
-		  << std::setw(10) << "LastUpdate"
-          << " |\n";
-
-       // Draw Grid + Dashboard
-       for (int row = 0; row < DISPLAY_HEIGHT; ++row) {
-           std::cout << "|";
-           for (int col = 0; col < DISPLAY_WIDTH; ++col) {
-               std::cout << screen[row][col];
-           }
-
-           std::cout << "|";
-
-           if (row < static_cast<int>(activeAircrafts.size())) {
-            const AircraftData& a = activeAircrafts[row];
-            std::ostringstream entryTimeStr, lastUpdatedStr;
-            entryTimeStr << std::put_time(std::localtime(&a.entryTime), "%H:%M:%S");
-            lastUpdatedStr << std::put_time(std::localtime(&a.lastupdatedTime), "%H:%M:%S");
-            std::cout << "|   "
-                      << std::setw(8) << std::left << blipMap[a.id]
-					  << std::setw(8) << a.id
-                      << std::setw(8) << static_cast<int>(a.x)
-                      << std::setw(8) << static_cast<int>(a.y)
-                      << std::setw(8) << static_cast<int>(a.z)
-                      << std::setw(6) << static_cast<int>(a.speedX)
-                      << std::setw(6) << static_cast<int>(a.speedY)
-                      << std::setw(4) << static_cast<int>(a.speedZ)
-					  << std::setw(10) << entryTimeStr.str()
-					  << std::setw(10) << lastUpdatedStr.str()
-                      << " |\n";
-            } else {
-                std::cout << "|   "
-                        << std::setw(8) << " "
-						<< std::setw(8) << " "
-                        << std::setw(8) << " "
-                        << std::setw(8) << " "
-                        << std::setw(8) << " "
-                        << std::setw(6) << " "
-                        << std::setw(6) << " "
-                        << std::setw(4) << " "
-						<< std::setw(10) << " "
-						<< std::setw(10) << " "
-                        << " |\n";
-            }
-        
-           std::cout << "|\n";
-       }
-
-       for (int col = 0; col < (DISPLAY_WIDTH * 2) + 31; ++col) std::cout << "=";
-       std::cout << "===\n";
-  }
-
-void setupOperatorConsoleConnection() {
-	std::cout << "Waiting for server " << OPERATOR_CONSOLE_CHANNEL_NAME << " to start...\n";
-	struct timespec wait_time = {1, 0};
-
-	while ((operator_coid = name_open(OPERATOR_CONSOLE_CHANNEL_NAME, 0)) == -1) {
-		nanosleep(&wait_time, NULL);
-	}
-	std::cout << "Connected to server '" << OPERATOR_CONSOLE_CHANNEL_NAME << "'\n";
-
+// Opened on the first command for the OperatorConsole, so a position that
+// only watches never holds a connection to it
+bool connectOperatorConsole() {
+    if (operator_coid != -1) return true;
+    operator_coid = name_open(OPERATOR_CONSOLE_CHANNEL_NAME, 0);
+    if (operator_coid == -1) {
+        perror("[DataDisplay] OperatorConsole is not running");
+        return false;
+    }
     std::cout << "[DataDisplay] Connected to OperatorConsole channel.\n";
+    return true;
 }
 
 void promptAndSendCommand() {
@@ -190,7 +140,13 @@ void promptAndSendCommand() {
 
     if (input.empty()) return;
 
-    if (operator_coid != -1) {
+    // Zoom, pan and altitude band belong to this display alone
+    pthread_mutex_lock(&viewport_mutex);
+    bool local = parseViewportCommand(input, viewport);
+    pthread_mutex_unlock(&viewport_mutex);
+    if (local) return;
+
+    if (connectOperatorConsole()) {
         int status = MsgSend(operator_coid, input.c_str(), input.size() + 1, nullptr, 0);
         if (status == -1) {
             perror("[DataDisplay] Failed to send message to OperatorConsole");
@@ -214,26 +170,94 @@ void* commandInputThread(void*) {
 
 
 
-int main() {
+// Gives up the client slot and writes the timing totals; runs on the
+// termination thread, not in a signal handler, and the signal then ends
+// the process as before
+void handle_termination(int) {
+    if (client != nullptr) client->detach();
+    if (on_terminal) renderer.release();
+    logger.close();
+}
+
+void handle_resize(int) {
+    resized = 1;
+}
+
+// A headless position has no screen, so it says what it has drawn
+void reportHeadless() {
+    std::cout << "[DataDisplaySystem] frames " << client->framesDrawn()
+              << " skipped " << client->publicationsSkipped()
+              << " cursor " << client->readCursor()
+              << " max latency " << client->maxLatencyNs() / 1000 << " us" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    // [hz] refresh rate, at most; --sector <x km>,<y km>,<zoom> and
+    // --alt <floor m>,<ceiling m> set the starting filter; --headless draws
+    // without a screen or prompt, for load testing
+    int refresh_hz = DEFAULT_REFRESH_HZ;
+    for (int i = 1; i < argc; i++) {
+        double x, y, zoom, floor, ceiling;
+        if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "--sector") == 0 && i + 1 < argc &&
+                   sscanf(argv[++i], "%lf,%lf,%lf", &x, &y, &zoom) == 3) {
+            viewport.moveTo(x * 1000, y * 1000);
+            viewport.setZoom(zoom);
+        } else if (strcmp(argv[i], "--alt") == 0 && i + 1 < argc &&
+                   sscanf(argv[++i], "%lf,%lf", &floor, &ceiling) == 2 && floor <= ceiling) {
+            viewport.floor = floor;
+            viewport.ceiling = ceiling;
+        } else if (atoi(argv[i]) > 0) {
+            refresh_hz = atoi(argv[i]);
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [hz] [--sector x_km,y_km,zoom] [--alt floor,ceiling] [--headless]\n";
+            return 1;
+        }
+    }
+    refresh_hz = std::max(1, std::min(refresh_hz, MAX_REFRESH_HZ));
+
+    signal(SIGWINCH, handle_resize);
+    on_terminal = !headless && isatty(STDOUT_FILENO);
     connectToSharedMemory();
-    setupOperatorConsoleConnection();
-    struct timespec delay;
-       delay.tv_sec = 0;
-       delay.tv_nsec = 100000000;
-    std::time_t lastUpdate = 0;
-    pthread_t inputThread;
-    pthread_create(&inputThread, nullptr, commandInputThread, nullptr);
+
+    client = new DisplayClient(snapshots);
+    if (!client->attach(getpid(), viewport)) {
+        std::cout << "[DataDisplaySystem] Client table full; drawing without a slot\n";
+    }
+    // Before any other thread starts, so they all leave the signals to it
+    startTerminationThread(handle_termination);
+    if (!headless) {
+        pthread_t inputThread;
+        pthread_create(&inputThread, nullptr, commandInputThread, nullptr);
+    }
+
+    // Each new publication is drawn as soon as it lands, but frames stay at
+    // least a period apart; with nothing new, the wait runs out after a
+    // period so a viewport change or resize is still redrawn
+    long period_ns = 1000000000L / refresh_hz;
+    timespec next = logger.now();
+    timespec last_report = next;
     while (true) {
-        std::time_t now = std::time(nullptr);
-        if (now - lastUpdate >= 1) {
-            clearScreen();
-            timespec start = logger.now();
-            drawAirspace();
-            timespec end = logger.now();
-    		logger.logDuration("drawAirspace", start, end);
-            lastUpdate = now;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        client->waitForPublication(period_ns / 1000000);
+        if (resized) {
+            resized = 0;
+            renderer.invalidate();
+        }
+        drawAirspace();
+
+        next = logger.now();
+        if (headless && next.tv_sec - last_report.tv_sec >= HEADLESS_REPORT_SEC) {
+            reportHeadless();
+            last_report = next;
+        }
+        next.tv_nsec += period_ns;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
         }
-        nanosleep(&delay, NULL);
     }
 
     return 0;
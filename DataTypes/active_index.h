@@ -0,0 +1,60 @@
+/*
+ * active_index.h
+ *
+ * Dense list of the slots that currently hold an aircraft in the air, kept
+ * in the shared segment next to the slot arrays. Consumers walk the first
+ * active_count entries instead of every slot up to the capacity, so a
+ * sweep costs O(active) however sparse the slots have become.
+ *
+ * Update protocol: entries are only added or removed inside an airspace
+ * write section, in the same section that writes or clears the slot's
+ * record. Removal moves the last entry into the hole, so the list stays
+ * packed. Readers go through AirspaceMapping::read(): a copy that raced an
+ * update is retried, and a retried copy never sees a half-moved entry.
+ * Readers still bound the count and the slot numbers by the capacity, so
+ * a torn attempt cannot read out of range before it is thrown away.
+ */
+
+#ifndef ACTIVE_INDEX_H_
+#define ACTIVE_INDEX_H_
+
+#include <algorithm>
+#include "airspace.h"
+
+// Caller is inside a write section. Adding a listed slot is a no-op.
+inline void publishActiveSlot(const AirspaceView& view, int slot) {
+	if (view.active_pos[slot] != 0) return;
+	int32_t pos = view.header->active_count++;
+	view.active_slots[pos] = slot;
+	view.active_pos[slot] = pos + 1;
+}
+
+// Caller is inside a write section. Removing an unlisted slot is a no-op.
+inline void retractActiveSlot(const AirspaceView& view, int slot) {
+	int32_t pos = view.active_pos[slot] - 1;
+	if (pos < 0) return;
+
+	int32_t last = --view.header->active_count;
+	int32_t moved = view.active_slots[last];
+	view.active_slots[pos] = moved;
+	view.active_pos[moved] = pos + 1;
+	view.active_pos[slot] = 0;
+}
+
+inline int activeSlotCount(const AirspaceView& view) {
+	return std::min(std::max(view.header->active_count, 0), view.capacity);
+}
+
+// Calls fn(slot) for every listed slot. Meant to run inside read() or a
+// write section; slot numbers outside the view are skipped.
+template <typename Fn>
+void forEachActiveSlot(const AirspaceView& view, Fn fn) {
+	int count = activeSlotCount(view);
+	for (int k = 0; k < count; k++) {
+		int slot = view.active_slots[k];
+		if (slot < 0 || slot >= view.capacity) continue;
+		fn(slot);
+	}
+}
+
+#endif /* ACTIVE_INDEX_H_ */
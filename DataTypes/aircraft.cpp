@@ -11,8 +11,7 @@
 #include "operator_command.h"
 #include "message_types.h"
 
-Airspace* Aircraft::shared_memory = nullptr;
-int Aircraft::aircraft_index = 0;
+AirspaceMapping* Aircraft::shared_memory = nullptr;
 
 Aircraft::Aircraft(time_t entryTime,
 				   int id,
@@ -22,7 +21,8 @@ Aircraft::Aircraft(time_t entryTime,
 				   double speedX,
 				   double speedY,
 				   double speedZ,
-				   Airspace* shared_mem):
+				   AirspaceMapping* shared_mem,
+				   SlotHandle slot):
 								   entryTime(entryTime),
 								   id(id),
 								   x(x),
@@ -31,12 +31,11 @@ Aircraft::Aircraft(time_t entryTime,
 						   	   	   speedX(speedX),
 								   speedY(speedY),
 								   speedZ(speedZ),
-								   running(true),
 								   attach(nullptr),
 								   service_name{0},
-								   position_thread(0),
 								   ipc_thread(0),
-								   shm_index(aircraft_index)
+								   shm_index(slot.slot),
+								   slot(slot)
 								   {
 
 	if (Aircraft::shared_memory == nullptr){ Aircraft::shared_memory = shared_mem; }
@@ -45,41 +44,19 @@ Aircraft::Aircraft(time_t entryTime,
 
 	lastupdatedTime = time(NULL);
 
-	Aircraft::shared_memory->aircraft_data[shm_index] = {entryTime, lastupdatedTime, id, x, y, z, speedX, speedY, speedZ, true, false};
+	const AirspaceView& airspace = shared_memory->beginWrite();
+	airspace.aircraft_data[shm_index] = {entryTime, lastupdatedTime, id, x, y, z, speedX, speedY, speedZ, true, false};
+	syncHotFields(airspace, shm_index);
+	publishActiveSlot(airspace, shm_index);
+	shared_memory->endWrite();
 
 //	std::cout << "Aircraft Created: " << id
-//	          << " Stored at: " << &Aircraft::shared_memory->aircraft_data[shm_index]
-//	          << " ID in Memory: " << Aircraft::shared_memory->aircraft_data[shm_index].id
+//	          << " Stored at: " << &Aircraft::shared_memory->view().aircraft_data[shm_index]
+//	          << " ID in Memory: " << Aircraft::shared_memory->view().aircraft_data[shm_index].id
 //	          << std::endl;
-
-	aircraft_index++;
 }
 
 
-void* Aircraft::updatePositionThread(void* arg) {
-    Aircraft* aircraft = static_cast<Aircraft*>(arg);
-
-    struct timespec req;
-    req.tv_sec = 1;         // 1 second
-    req.tv_nsec = 0;        // 0 nanoseconds
-
-    while (aircraft->running) {
-
-        pthread_mutex_lock(&shared_memory->lock);
-
-        Aircraft::shared_memory->aircraft_data[aircraft->shm_index].x += aircraft->speedX;
-        Aircraft::shared_memory->aircraft_data[aircraft->shm_index].y += aircraft->speedY;
-        Aircraft::shared_memory->aircraft_data[aircraft->shm_index].z += aircraft->speedZ;
-        Aircraft::shared_memory->aircraft_data[aircraft->shm_index].lastupdatedTime = time(nullptr);
-
-        pthread_mutex_unlock(&shared_memory->lock);
-
-        nanosleep(&req, NULL);
-    }
-
-    return nullptr;
-}
-
 void* Aircraft::messageHandlerThread(void* arg) {
 	Aircraft* aircraft = static_cast<Aircraft*>(arg);
 
@@ -122,17 +99,14 @@ void* Aircraft::messageHandlerThread(void* arg) {
 	return nullptr;
 }
 
+// Positions are advanced by the SimulationEngine; an aircraft only serves
+// its IPC channel.
 void Aircraft::startThreads(){
-	pthread_create(&position_thread, nullptr, updatePositionThread, this);
 	pthread_create(&ipc_thread, nullptr, messageHandlerThread, this);
 }
 
 
 void Aircraft::stopThreads() {
-	running = false;
-	pthread_join(position_thread, nullptr);
-	std::cout << "[DEBUG] position_thread joined\n";
-
 	// ipc_thread can stay blocked on MsgReceive() under certain conditions.
 	// Changed to infinite while loop that will wait for terminator message.
 	send_terminator_message();
@@ -160,34 +134,35 @@ void Aircraft::send_terminator_message() {
 
 void Aircraft::handle_operator_message(int rcvid, OperatorCommand* cmd) {
 	// Lock shared memory before updating position
-	pthread_mutex_lock(&shared_memory->lock);
+	const AirspaceView& airspace = shared_memory->beginWrite();
 
 	if (cmd->type == CommandType::ChangeSpeed) {
 		this->speedX = cmd->speed.vx;
 		this->speedY = cmd->speed.vy;
 		this->speedZ = cmd->speed.vz;
 
-        Aircraft::shared_memory->aircraft_data[this->shm_index].speedX = cmd->speed.vx;
-        Aircraft::shared_memory->aircraft_data[this->shm_index].speedY = cmd->speed.vy;
-        Aircraft::shared_memory->aircraft_data[this->shm_index].speedZ = cmd->speed.vz;
+        airspace.aircraft_data[this->shm_index].speedX = cmd->speed.vx;
+        airspace.aircraft_data[this->shm_index].speedY = cmd->speed.vy;
+        airspace.aircraft_data[this->shm_index].speedZ = cmd->speed.vz;
 		std::cout << "[Aircraft] Speed updated to: (" << this->speedX << ", "
 				  << this->speedY << ", " << this->speedZ << ")" << std::endl;
 	} else if (cmd->type == CommandType::ChangePosition) {
 
-		Aircraft::shared_memory->aircraft_data[this->shm_index].x = cmd->position.x;
-		Aircraft::shared_memory->aircraft_data[this->shm_index].y = cmd->position.y;
-		Aircraft::shared_memory->aircraft_data[this->shm_index].z = cmd->position.z;
+		airspace.aircraft_data[this->shm_index].x = cmd->position.x;
+		airspace.aircraft_data[this->shm_index].y = cmd->position.y;
+		airspace.aircraft_data[this->shm_index].z = cmd->position.z;
 		std::cout << "[Aircraft] Position updated to: (" << cmd->position.x << ", "
 				  << cmd->position.y << ", " << cmd->position.z << ")" << std::endl;
 	}
 	else if (cmd->type == CommandType::RequestDetails) {
 
-		std::cout << "[Aircraft] Position : (" << Aircraft::shared_memory->aircraft_data[this->shm_index].x << ", "
-				  << shared_memory->aircraft_data[this->shm_index].y << ", " << shared_memory->aircraft_data[this->shm_index].z << ")" << std::endl;
-		std::cout << "[Aircraft] Speed : (" << Aircraft::shared_memory->aircraft_data[this->shm_index].speedX << ", "
-						  << Aircraft::shared_memory->aircraft_data[this->shm_index].speedY << ", " << Aircraft::shared_memory->aircraft_data[this->shm_index].speedZ << ")" << std::endl;
+		std::cout << "[Aircraft] Position : (" << airspace.aircraft_data[this->shm_index].x << ", "
+				  << airspace.aircraft_data[this->shm_index].y << ", " << airspace.aircraft_data[this->shm_index].z << ")" << std::endl;
+		std::cout << "[Aircraft] Speed : (" << airspace.aircraft_data[this->shm_index].speedX << ", "
+						  << airspace.aircraft_data[this->shm_index].speedY << ", " << airspace.aircraft_data[this->shm_index].speedZ << ")" << std::endl;
 	}
-	pthread_mutex_unlock(&shared_memory->lock);
+	syncHotFields(airspace, this->shm_index);
+	shared_memory->endWrite();
 
 	MsgReply(rcvid, 0, NULL, 0);
 }
@@ -196,12 +171,18 @@ void Aircraft::handle_radar_message(int rcvid, RadarMessage* radar_message) {
 
 	std::cout << "[Aircraft " << this->id << "] Sending identification to Radar...\n";
 
+	// The engine only moves the shared record, so reply from there
+	AircraftData current;
+	shared_memory->read([&](const AirspaceView& airspace) {
+		current = airspace.aircraft_data[this->shm_index];
+	});
+
 	RadarReply reply_msg = {
 			time(NULL),
 			"Here's my id and heading bro",
 			this->id,
-			this->x, this->y, this->z,
-			this->speedX, this->speedY, this->speedZ
+			current.x, current.y, current.z,
+			current.speedX, current.speedY, current.speedZ
 	};
 	MsgReply(rcvid, 0, &reply_msg, sizeof(reply_msg));
 }
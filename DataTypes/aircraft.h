@@ -3,25 +3,26 @@
 #include <sys/dispatch.h>
 #include "aircraft_data.h"
 #include "airspace.h"
+#include "slot_allocator.h"
+#include "active_index.h"
 #include "message_types.h"
 
 class Aircraft {
 
 private:
-	static Airspace* shared_memory;
-	static int aircraft_index;
+	static AirspaceMapping* shared_memory;
 
 public:
 	time_t entryTime, lastupdatedTime;
 	int id;
 	double x, y, z;
 	double speedX, speedY, speedZ;
-	bool running;
 	name_attach_t* attach;
 	char service_name[20];
-	pthread_t position_thread, ipc_thread;
+	pthread_t ipc_thread;
 	std::mutex lock;
 	int shm_index;
+	SlotHandle slot;
 
 	Aircraft(time_t entryTime,
 			 int id,
@@ -31,7 +32,8 @@ public:
 			 double speedX,
 			 double speedY,
 			 double speedZ,
-			 Airspace* shared_mem);
+			 AirspaceMapping* shared_mem,
+			 SlotHandle slot);
 
 	~Aircraft();
 
@@ -39,7 +41,6 @@ public:
 	void stopThreads();
 	void send_terminator_message();
 
-	static void* updatePositionThread(void* arg);
 	static void* messageHandlerThread(void* arg);
 	void handle_operator_message(int, OperatorCommand*);
 	void handle_radar_message(int, RadarMessage*);
@@ -10,8 +10,6 @@
 
 #include <time.h>
 
-#define MAX_AIRCRAFT 100
-
 struct AircraftData {
 	time_t entryTime, lastupdatedTime;
     int id;
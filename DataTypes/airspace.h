@@ -8,18 +8,521 @@
 #ifndef AIRSPACE_H_
 #define AIRSPACE_H_
 
+#include <pthread.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <vector>
 #include "aircraft_data.h"
+#include "performance_metrics.h"
+#include "shm_event.h"
 
 #define AIRSPACE_SHM_NAME "/airspace_shm"
-#define MAX_AIRCRAFT 100
+#define AIRSPACE_MAGIC 0x41495253          // "AIRS"
+#define AIRSPACE_LAYOUT_VERSION 5
+#define DEFAULT_AIRSPACE_CAPACITY 100
+
+// The segment is a fixed header followed by one array per slot field. The
+// arrays are sized from the capacity stored in the header, so the segment
+// can be created and grown at runtime. Hot fields are kept as separate
+// contiguous arrays (structure of arrays) so the checkers and the radar
+// stream doubles instead of whole AircraftData records.
+enum AirspaceArray {
+	ARRAY_AIRCRAFT,
+	ARRAY_X, ARRAY_Y, ARRAY_Z,
+	ARRAY_VX, ARRAY_VY, ARRAY_VZ,
+	ARRAY_ACTIVE,
+	ARRAY_SLOT_GEN, ARRAY_SLOT_NEXT,
+	ARRAY_ACTIVE_SLOTS, ARRAY_ACTIVE_POS,
+	AIRSPACE_ARRAY_COUNT
+};
+
+static const size_t airspaceElementSize[AIRSPACE_ARRAY_COUNT] = {
+	sizeof(AircraftData),
+	sizeof(double), sizeof(double), sizeof(double),
+	sizeof(double), sizeof(double), sizeof(double),
+	sizeof(uint8_t),
+	sizeof(std::atomic<uint32_t>), sizeof(std::atomic<uint32_t>),
+	sizeof(int32_t), sizeof(int32_t)
+};
+
+// Byte offsets of each array from the start of the segment
+struct AirspaceLayout {
+	uint64_t offset[AIRSPACE_ARRAY_COUNT];
+};
 
 struct Airspace {
-	pthread_mutex_t lock;
+	uint32_t magic;                    // set last, once the header is valid
+	uint32_t layout_version;
+	pthread_mutex_t lock;              // serializes writers only
+	std::atomic<uint32_t> generation;  // seqlock counter, odd while a write is in progress
+	std::atomic<uint32_t> resize_epoch; // bumped every time the arrays move
+	uint64_t segment_size;
+	int capacity;
 	int aircraft_count;
 	bool updated;
-	AircraftData aircraft_data[MAX_AIRCRAFT];
+	AirspaceLayout layout;
+
+	// Slot allocator state, see slot_allocator.h
+	std::atomic<uint64_t> free_head;   // ABA tag << 32 | (slot + 1), 0 when empty
+	std::atomic<int32_t> high_water;   // slots ever handed out; no live slot is above it
+	std::atomic<int32_t> live_count;
+
+	// Packed index of the slots in the air, see active_index.h
+	int32_t active_count;
+
+	// Whole traffic frames (simulation ticks or replayed frames), each
+	// published in one write section. While a replay runs in lockstep it
+	// waits for the ComputerSystem to report each frame checked.
+	std::atomic<uint64_t> frame;
+	std::atomic<uint32_t> lockstep;
+	std::atomic<uint64_t> checked_frame;
+	ShmEvent frame_ready;              // signalled after every frame
+	ShmEvent frame_checked;            // signalled by the ComputerSystem
+};
+
+// Read-only view of hot fields, either the shared mirror or a local copy
+struct SoAView {
+	const double *x, *y, *z;
+	const double *vx, *vy, *vz;
+	const uint8_t* active;
+};
+
+// Process-local pointers into one mapping of the segment
+struct AirspaceView {
+	Airspace* header;
+	uint32_t epoch;
+	int capacity;
+	AircraftData* aircraft_data;
+	double *x, *y, *z;
+	double *vx, *vy, *vz;
+	uint8_t* active;
+	std::atomic<uint32_t>* slot_gen;   // odd while the slot is allocated
+	std::atomic<uint32_t>* slot_next;  // free list link, slot + 1 or 0
+	int32_t* active_slots;             // first active_count entries are live slots
+	int32_t* active_pos;               // position in active_slots + 1, 0 if not listed
+
+	SoAView hot() const { return {x, y, z, vx, vy, vz, active}; }
 };
 
+inline uint64_t alignAirspace(uint64_t n, uint64_t to) {
+	return (n + to - 1) / to * to;
+}
+
+// Offsets only ever grow with capacity, which is what lets grow() move the
+// arrays in place from the last one to the first.
+inline AirspaceLayout airspaceLayoutFor(int capacity, uint64_t* segment_size) {
+	AirspaceLayout layout;
+	uint64_t offset = alignAirspace(sizeof(Airspace), 64);
+	for (int k = 0; k < AIRSPACE_ARRAY_COUNT; k++) {
+		layout.offset[k] = offset;
+		offset = alignAirspace(offset + capacity * airspaceElementSize[k], 64);
+	}
+	*segment_size = alignAirspace(offset, 4096);
+	return layout;
+}
+
+inline AirspaceView airspaceViewAt(void* base, uint32_t epoch, int capacity,
+                                   const AirspaceLayout& layout) {
+	char* b = static_cast<char*>(base);
+	AirspaceView v;
+	v.header = static_cast<Airspace*>(base);
+	v.epoch = epoch;
+	v.capacity = capacity;
+	v.aircraft_data = reinterpret_cast<AircraftData*>(b + layout.offset[ARRAY_AIRCRAFT]);
+	v.x  = reinterpret_cast<double*>(b + layout.offset[ARRAY_X]);
+	v.y  = reinterpret_cast<double*>(b + layout.offset[ARRAY_Y]);
+	v.z  = reinterpret_cast<double*>(b + layout.offset[ARRAY_Z]);
+	v.vx = reinterpret_cast<double*>(b + layout.offset[ARRAY_VX]);
+	v.vy = reinterpret_cast<double*>(b + layout.offset[ARRAY_VY]);
+	v.vz = reinterpret_cast<double*>(b + layout.offset[ARRAY_VZ]);
+	v.active = reinterpret_cast<uint8_t*>(b + layout.offset[ARRAY_ACTIVE]);
+	v.slot_gen  = reinterpret_cast<std::atomic<uint32_t>*>(b + layout.offset[ARRAY_SLOT_GEN]);
+	v.slot_next = reinterpret_cast<std::atomic<uint32_t>*>(b + layout.offset[ARRAY_SLOT_NEXT]);
+	v.active_slots = reinterpret_cast<int32_t*>(b + layout.offset[ARRAY_ACTIVE_SLOTS]);
+	v.active_pos   = reinterpret_cast<int32_t*>(b + layout.offset[ARRAY_ACTIVE_POS]);
+	return v;
+}
+
+// Copies slot i into the SoA mirror. Writers call this, inside a write,
+// after every change to the position or speed of aircraft_data[i].
+inline void syncHotFields(const AirspaceView& view, int i) {
+	const AircraftData& a = view.aircraft_data[i];
+	view.x[i]  = a.x;
+	view.y[i]  = a.y;
+	view.z[i]  = a.z;
+	view.vx[i] = a.speedX;
+	view.vy[i] = a.speedY;
+	view.vz[i] = a.speedZ;
+	view.active[i] = a.id != 0;
+}
+
+// Writers still serialize on the mutex; bumping the generation around the
+// update is what lets readers detect that they raced with it. Only a
+// contended lock is timed, so the common path costs no clock reads.
+inline void beginAirspaceWrite(Airspace* airspace) {
+	if (pthread_mutex_trylock(&airspace->lock) != 0) {
+		static MetricHistogram lock_wait = metrics().histogram("airspaceLockWait");
+		timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		pthread_mutex_lock(&airspace->lock);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		lock_wait.record(start, end);
+	}
+	uint32_t g = airspace->generation.load(std::memory_order_relaxed);
+	airspace->generation.store(g + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void endAirspaceWrite(Airspace* airspace) {
+	uint32_t g = airspace->generation.load(std::memory_order_relaxed);
+	airspace->generation.store(g + 1, std::memory_order_release);
+	pthread_mutex_unlock(&airspace->lock);
+}
+
+// Called inside the write section that completes a frame of traffic.
+// Returns the new frame number.
+inline uint64_t markAirspaceFrame(Airspace* airspace) {
+	return airspace->frame.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+// Called after the write section, to wake whoever waits for frames
+inline void announceAirspaceFrame(Airspace* airspace) {
+	signalShmEvent(&airspace->frame_ready);
+}
+
+// Lock-free reader: runs copy() until it completes without a writer
+// touching the segment, so the caller gets a consistent snapshot without
+// ever blocking a writer. copy() must only fill caller-owned buffers and
+// must restart them from scratch, since it can run more than once.
+// Returns the generation the snapshot was taken at.
+template <typename Fn>
+uint32_t readAirspaceSnapshot(const Airspace* airspace, Fn copy) {
+	while (true) {
+		uint32_t before = airspace->generation.load(std::memory_order_acquire);
+		if (before & 1) {
+			sched_yield();
+			continue;
+		}
+
+		copy();
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (airspace->generation.load(std::memory_order_relaxed) == before) {
+			return before;
+		}
+	}
+}
+
+// One process's mapping of the airspace segment.
+//
+// Resize protocol: the owner grows the segment inside a write section,
+// moves the arrays to their new offsets and bumps resize_epoch. Every
+// other process notices the new epoch on its next read or write, maps the
+// larger segment and switches to a fresh view. Superseded mappings are
+// kept until close() so a thread still holding an old view never touches
+// unmapped memory; growth doubles, so they add up to less than the final
+// size.
+class AirspaceMapping {
+
+private:
+	int fd = -1;
+	bool writable = false;
+	bool anonymous = false;
+	void* base = nullptr;
+	size_t mapped = 0;
+	std::atomic<const AirspaceView*> current{nullptr};
+	pthread_mutex_t remap_lock = PTHREAD_MUTEX_INITIALIZER;
+	std::vector<std::pair<void*, size_t>> retired_maps;
+	std::vector<const AirspaceView*> retired_views;
+
+	void* mapSegment(size_t size) {
+		int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+		void* addr = anonymous
+			? mmap(NULL, size, prot, MAP_SHARED | MAP_ANONYMOUS, -1, 0)
+			: mmap(NULL, size, prot, MAP_SHARED, fd, 0);
+		return addr == MAP_FAILED ? nullptr : addr;
+	}
+
+	void install(void* addr, size_t size, const AirspaceView& view) {
+		if (base != nullptr && base != addr) {
+			retired_maps.push_back({base, mapped});
+		}
+		base = addr;
+		mapped = size;
+		const AirspaceView* old = current.exchange(new AirspaceView(view), std::memory_order_acq_rel);
+		if (old != nullptr) retired_views.push_back(old);
+	}
+
+	// Caller holds remap_lock. Maps the segment again if it grew and
+	// rebuilds the view from a consistent read of the header; a caller
+	// already inside a write section can read the header directly.
+	bool remap(bool write_locked) {
+		Airspace* h = static_cast<Airspace*>(base);
+		uint64_t size;
+		uint32_t epoch;
+		int capacity;
+		AirspaceLayout layout;
+		auto copy = [&] {
+			size = h->segment_size;
+			epoch = h->resize_epoch.load(std::memory_order_relaxed);
+			capacity = h->capacity;
+			layout = h->layout;
+		};
+		if (write_locked) copy();
+		else readAirspaceSnapshot(h, copy);
+
+		void* addr = base;
+		if (size > mapped) {
+			addr = mapSegment(size);
+			if (addr == nullptr) {
+				perror("[Airspace] remap failed");
+				return false;
+			}
+		}
+		install(addr, size > mapped ? size : mapped, airspaceViewAt(addr, epoch, capacity, layout));
+		return true;
+	}
+
+public:
+	~AirspaceMapping() { close(false); }
 
+	Airspace* header() const { return view().header; }
+	const AirspaceView& view() const { return *current.load(std::memory_order_acquire); }
+	int capacity() const { return view().capacity; }
+
+	// Owner side: creates (or truncates) the segment for the given number of
+	// slots. A null name gives a private anonymous mapping that cannot grow.
+	bool create(const char* name, int capacity) {
+		writable = true;
+		anonymous = name == nullptr;
+
+		uint64_t size;
+		AirspaceLayout layout = airspaceLayoutFor(capacity, &size);
+
+		if (!anonymous) {
+			fd = shm_open(name, O_CREAT | O_RDWR, 0666);
+			if (fd == -1) {
+				perror("shm_open failed");
+				return false;
+			}
+			if (ftruncate(fd, size) == -1) {
+				perror("ftruncate failed for aircraft data");
+				return false;
+			}
+		}
+
+		void* addr = mapSegment(size);
+		if (addr == nullptr) {
+			perror("mmap failed");
+			return false;
+		}
+
+		// Initialize the shared memory to 0x0 before the mutex, not after it
+		memset(addr, 0, size);
+		Airspace* h = static_cast<Airspace*>(addr);
+
+		pthread_mutexattr_t attr;
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+		pthread_mutex_init(&h->lock, &attr);
+		h->generation.store(0);
+		h->resize_epoch.store(0);
+		h->free_head.store(0);
+		h->high_water.store(0);
+		h->live_count.store(0);
+		h->frame.store(0);
+		h->lockstep.store(0);
+		h->checked_frame.store(0);
+		initShmEvent(&h->frame_ready);
+		initShmEvent(&h->frame_checked);
+		h->layout_version = AIRSPACE_LAYOUT_VERSION;
+		h->segment_size = size;
+		h->capacity = capacity;
+		h->layout = layout;
+		std::atomic_thread_fence(std::memory_order_release);
+		h->magic = AIRSPACE_MAGIC;
+
+		install(addr, size, airspaceViewAt(addr, 0, capacity, layout));
+		return true;
+	}
+
+	// Consumer side: maps an existing segment. Returns false while the owner
+	// has not finished creating it, so callers can keep their retry loops.
+	bool attach(const char* name, bool write_access) {
+		writable = write_access;
+		anonymous = false;
+
+		fd = shm_open(name, write_access ? O_RDWR : O_RDONLY, 0666);
+		if (fd == -1) return false;
+
+		struct stat st;
+		if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(Airspace)) {
+			::close(fd);
+			fd = -1;
+			return false;
+		}
+
+		void* addr = mapSegment(st.st_size);
+		if (addr == nullptr) {
+			perror("[Airspace] mmap failed");
+			::close(fd);
+			fd = -1;
+			return false;
+		}
+
+		Airspace* h = static_cast<Airspace*>(addr);
+		if (h->magic != AIRSPACE_MAGIC) {
+			munmap(addr, st.st_size);
+			::close(fd);
+			fd = -1;
+			return false;
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (h->layout_version != AIRSPACE_LAYOUT_VERSION) {
+			fprintf(stderr, "[Airspace] segment layout version %u, expected %u\n",
+			        h->layout_version, AIRSPACE_LAYOUT_VERSION);
+			munmap(addr, st.st_size);
+			::close(fd);
+			fd = -1;
+			return false;
+		}
+
+		base = addr;
+		mapped = st.st_size;
+		pthread_mutex_lock(&remap_lock);
+		bool ok = remap(false);
+		pthread_mutex_unlock(&remap_lock);
+		return ok;
+	}
+
+	// Follows a resize made by another process. Cheap when nothing changed.
+	void refresh(bool write_locked = false) {
+		Airspace* h = header();
+		if (h->resize_epoch.load(std::memory_order_acquire) == view().epoch) return;
+
+		pthread_mutex_lock(&remap_lock);
+		if (h->resize_epoch.load(std::memory_order_acquire) != view().epoch) {
+			remap(write_locked);
+		}
+		pthread_mutex_unlock(&remap_lock);
+	}
+
+	// Seqlock read through the current view. copy(view) is retried until
+	// no write overlapped it; a resize is a write, so a copy taken through
+	// a view that went stale is thrown away and redone through the new one.
+	template <typename Fn>
+	uint32_t read(Fn copy) {
+		Airspace* h = header();
+		while (true) {
+			refresh();
+			const AirspaceView& v = view();
+			bool stale = false;
+			uint32_t generation = readAirspaceSnapshot(h, [&] {
+				stale = h->resize_epoch.load(std::memory_order_relaxed) != v.epoch;
+				if (!stale) copy(v);
+			});
+			if (!stale) return generation;
+		}
+	}
+
+	// Write section through a view that stays current until endWrite(),
+	// since resizes are writes too.
+	const AirspaceView& beginWrite() {
+		beginAirspaceWrite(header());
+		refresh(true);
+		return view();
+	}
+
+	void endWrite() {
+		endAirspaceWrite(header());
+	}
+
+	// Owner side: grows the slot arrays to hold at least `needed` slots, at
+	// least doubling so repeated spawns resize rarely. Other processes
+	// follow through refresh(); existing slots keep their index.
+	// The slot allocator's arrays move too, so the owner must not allocate
+	// or release slots from another thread while this runs.
+	bool grow(int needed) {
+		if (anonymous) return false;
+
+		Airspace* h = header();
+		beginAirspaceWrite(h);
+		pthread_mutex_lock(&remap_lock);
+
+		int old_capacity = h->capacity;
+		if (needed <= old_capacity) {
+			pthread_mutex_unlock(&remap_lock);
+			endAirspaceWrite(h);
+			return true;
+		}
+		int new_capacity = std::max(needed, old_capacity * 2);
+
+		uint64_t size;
+		AirspaceLayout old_layout = h->layout;
+		AirspaceLayout layout = airspaceLayoutFor(new_capacity, &size);
+
+		void* addr = nullptr;
+		if (ftruncate(fd, size) == -1 || (addr = mapSegment(size)) == nullptr) {
+			perror("[Airspace] grow failed");
+			pthread_mutex_unlock(&remap_lock);
+			endAirspaceWrite(h);
+			return false;
+		}
+
+		// Last array first: each one only moves up, over space already vacated
+		char* b = static_cast<char*>(addr);
+		for (int k = AIRSPACE_ARRAY_COUNT - 1; k >= 0; k--) {
+			size_t used = old_capacity * airspaceElementSize[k];
+			size_t added = (new_capacity - old_capacity) * airspaceElementSize[k];
+			memmove(b + layout.offset[k], b + old_layout.offset[k], used);
+			memset(b + layout.offset[k] + used, 0, added);
+		}
+
+		Airspace* nh = static_cast<Airspace*>(addr);
+		nh->layout = layout;
+		nh->capacity = new_capacity;
+		nh->segment_size = size;
+		uint32_t epoch = nh->resize_epoch.load(std::memory_order_relaxed) + 1;
+		nh->resize_epoch.store(epoch, std::memory_order_release);
+
+		install(addr, size, airspaceViewAt(addr, epoch, new_capacity, layout));
+		pthread_mutex_unlock(&remap_lock);
+		endAirspaceWrite(nh);
+		return true;
+	}
+
+	void close(bool unlink_name, const char* name = AIRSPACE_SHM_NAME) {
+		if (base == nullptr) return;
+		for (auto& m : retired_maps) munmap(m.first, m.second);
+		retired_maps.clear();
+		if (munmap(base, mapped) == 0 && unlink_name) {
+			std::cout << "Shared memory unmapped successfully." << std::endl;
+		}
+		base = nullptr;
+		if (fd != -1) ::close(fd);
+		fd = -1;
+
+		if (unlink_name) {
+			if (shm_unlink(name) == 0) {
+				std::cout << "Shared memory unlinked successfully." << std::endl;
+			} else {
+				perror("shm_unlink failed");
+			}
+		}
+
+		for (const AirspaceView* v : retired_views) delete v;
+		retired_views.clear();
+		delete current.exchange(nullptr);
+	}
+};
 
 #endif /* AIRSPACE_H_ */
@@ -0,0 +1,116 @@
+/*
+ * airspace_display.h
+ *
+ * Text rendering of the DataDisplay's airspace view: a DISPLAY_WIDTH x
+ * DISPLAY_HEIGHT plan view of the detected aircraft in the viewport beside
+ * a table of their records. A cell holding one aircraft shows its blip
+ * letter and a busier one the count, '*' above nine, which is what most
+ * cells show when zoomed out over heavy traffic.
+ *
+ * These are the pieces of a DisplayFrame, a fixed-size character frame
+ * that readDisplaySnapshot() fills without streams or allocation and the
+ * terminal renderer diffs against the previous frame.
+ */
+
+#ifndef AIRSPACE_DISPLAY_H_
+#define AIRSPACE_DISPLAY_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <ctime>
+#include "aircraft_data.h"
+#include "display_viewport.h"
+
+// Border, column titles, one line per grid row, border. A grid row is
+// the cells, a divider and the table row.
+#define DISPLAY_ROW_WIDTH 76
+#define FRAME_COLUMNS (DISPLAY_WIDTH + DISPLAY_ROW_WIDTH + 8)
+#define FRAME_ROWS (DISPLAY_HEIGHT + 3)
+
+struct DisplayFrame {
+    char cells[FRAME_ROWS][FRAME_COLUMNS];
+};
+
+// Writes text left-aligned into a field of the given width, cut to fit
+inline char* putField(char* at, const char* text, int width) {
+    int n = 0;
+    while (n < width && text[n] != '\0') {
+        at[n] = text[n];
+        n++;
+    }
+    memset(at + n, ' ', width - n);
+    return at + width;
+}
+
+inline char* putField(char* at, long value, int width) {
+    char digits[24];
+    char* p = digits + sizeof(digits);
+    *--p = '\0';
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do {
+        *--p = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) *--p = '-';
+    return putField(at, p, width);
+}
+
+// "HH:MM:SS" in local time, or empty
+inline void formatClock(time_t t, char text[16]) {
+    tm local;
+    if (localtime_r(&t, &local) == nullptr ||
+        strftime(text, 16, "%H:%M:%S", &local) == 0) {
+        text[0] = '\0';
+    }
+}
+
+// One table row, DISPLAY_ROW_WIDTH characters
+inline char* putTrackRow(char* at, char blip, const AircraftData& a,
+                         const char* entry, const char* updated) {
+    char blip_text[2] = {blip, '\0'};
+    at = putField(at, blip_text, 8);
+    at = putField(at, a.id, 8);
+    at = putField(at, static_cast<long>(a.x), 8);
+    at = putField(at, static_cast<long>(a.y), 8);
+    at = putField(at, static_cast<long>(a.z), 8);
+    at = putField(at, static_cast<long>(a.speedX), 6);
+    at = putField(at, static_cast<long>(a.speedY), 6);
+    at = putField(at, static_cast<long>(a.speedZ), 4);
+    at = putField(at, entry, 10);
+    return putField(at, updated, 10);
+}
+
+// Grid cell character for n aircraft, the first of which has blip
+inline char displayCell(int n, char blip) {
+    return n == 1 ? blip : n <= 9 ? '0' + n : '*';
+}
+
+// Top and bottom borders and the column titles
+inline void composeFrameBorders(DisplayFrame& frame, const char* title) {
+    memset(frame.cells[0], '=', FRAME_COLUMNS);
+    memset(frame.cells[FRAME_ROWS - 1], '=', FRAME_COLUMNS);
+
+    char* at = frame.cells[1];
+    *at++ = '|';
+    at = putField(at, title, DISPLAY_WIDTH);
+    at = putField(at, "||   ", 5);
+    at = putField(at, "BLIP", 8);
+    at = putField(at, "ID", 8);
+    at = putField(at, "X", 8);
+    at = putField(at, "Y", 8);
+    at = putField(at, "Z", 8);
+    at = putField(at, "VX", 6);
+    at = putField(at, "VY", 6);
+    at = putField(at, "VZ", 4);
+    at = putField(at, "Entry", 10);
+    at = putField(at, "LastUpdate", 10);
+    putField(at, " |", 2);
+}
+
+inline void formatViewportTitle(char* title, size_t size, const Viewport& viewport, int shown) {
+    snprintf(title, size, " AIRSPACE x%g @%.0f,%.0fkm z%.0f-%.0fm n%d",
+             viewport.zoom, viewport.center_x / 1000, viewport.center_y / 1000,
+             viewport.floor, viewport.ceiling, shown);
+}
+
+#endif /* AIRSPACE_DISPLAY_H_ */
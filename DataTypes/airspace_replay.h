@@ -0,0 +1,163 @@
+/*
+ * airspace_replay.h
+ *
+ * Plays frames of a flight recording back into the airspace. Each frame
+ * is applied in one write section and counted as one airspace frame, the
+ * way a simulation tick is, so readers only ever see whole frames.
+ *
+ * Recorded slot numbers belong to the recorded session. Each is given a
+ * slot here when it first appears, and the slot is released once the
+ * aircraft is missing from a frame; a recorded slot that comes back with
+ * a different aircraft id gets a fresh slot. Replayed aircraft have no
+ * position threads or IPC channels: positions, velocities and the
+ * detected/responded flags all come from the recording.
+ *
+ * The operator's commands are replayed from the console's history log,
+ * which loadOperatorHistory() reads back.
+ */
+
+#ifndef AIRSPACE_REPLAY_H_
+#define AIRSPACE_REPLAY_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "airspace.h"
+#include "active_index.h"
+#include "flight_recorder.h"
+#include "slot_allocator.h"
+
+#define OPERATOR_HISTORY_PATH "/tmp/operator_history.txt"
+
+struct HistoryCommand {
+    time_t when;
+    std::string command;
+};
+
+// Reads lines like "[2025-04-01 12:00:00] ChangeSpeed 3 10 0 0", in local
+// time as the console wrote them; anything else is skipped.
+inline bool loadOperatorHistory(const char* path, std::vector<HistoryCommand>& out) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.size() < 22 || line[0] != '[' || line[20] != ']') continue;
+
+        tm t = {};
+        if (strptime(line.c_str() + 1, "%Y-%m-%d %H:%M:%S", &t) == nullptr) continue;
+        t.tm_isdst = -1;
+
+        size_t start = line.find_first_not_of(' ', 21);
+        if (start == std::string::npos) continue;
+        out.push_back({mktime(&t), line.substr(start)});
+    }
+    return true;
+}
+
+class AirspaceReplay {
+
+private:
+    struct Placement {
+        SlotHandle slot;
+        int id;
+        uint64_t pass;          // last apply() that listed it
+    };
+
+    AirspaceMapping* airspace;
+    std::unordered_map<int32_t, Placement> placed;     // by recorded slot
+    std::vector<SlotHandle> replaced;
+    uint64_t pass = 0;
+
+    // Owner side, outside a write section, like the manager's spawns
+    SlotHandle acquire() {
+        SlotHandle slot = allocateSlot(airspace->view());
+        while (!slot.valid()) {
+            if (!airspace->grow(airspace->capacity() + 1)) return INVALID_SLOT;
+            slot = allocateSlot(airspace->view());
+        }
+        return slot;
+    }
+
+    static void vacate(const AirspaceView& view, SlotHandle slot) {
+        retractActiveSlot(view, slot.slot);
+        memset(&view.aircraft_data[slot.slot], 0, sizeof(AircraftData));
+        syncHotFields(view, slot.slot);
+        releaseSlot(view, slot);
+    }
+
+public:
+    explicit AirspaceReplay(AirspaceMapping* airspace) : airspace(airspace) {}
+
+    // Makes the airspace hold exactly the aircraft of one recorded frame.
+    // Returns the airspace frame number it was published as.
+    uint64_t apply(const std::vector<RecordedAircraft>& aircraft, time_t timestamp) {
+        pass++;
+
+        // Slots are allocated, and the segment grown, before the write
+        // section, since growing is a write section of its own
+        for (const RecordedAircraft& r : aircraft) {
+            auto it = placed.find(r.slot);
+            if (it != placed.end()) {
+                if (it->second.id == r.id) continue;
+                replaced.push_back(it->second.slot);
+                placed.erase(it);
+            }
+            SlotHandle slot = acquire();
+            if (!slot.valid()) {
+                fprintf(stderr, "[AirspaceReplay] No slot for aircraft %d\n", r.id);
+                continue;
+            }
+            placed[r.slot] = {slot, r.id, 0};
+        }
+
+        const AirspaceView& view = airspace->beginWrite();
+        for (SlotHandle slot : replaced) vacate(view, slot);
+        replaced.clear();
+
+        for (const RecordedAircraft& r : aircraft) {
+            auto it = placed.find(r.slot);
+            if (it == placed.end()) continue;
+            it->second.pass = pass;
+
+            int i = it->second.slot.slot;
+            AircraftData& a = view.aircraft_data[i];
+            if (a.id != r.id) a.entryTime = timestamp;
+            a.id = r.id;
+            a.x = r.x;
+            a.y = r.y;
+            a.z = r.z;
+            a.speedX = r.vx;
+            a.speedY = r.vy;
+            a.speedZ = r.vz;
+            a.detected = (r.status & CONTACT_DETECTED) != 0;
+            a.responded = (r.status & CONTACT_RESPONDED) != 0;
+            a.lastupdatedTime = timestamp;
+            syncHotFields(view, i);
+            publishActiveSlot(view, i);
+        }
+
+        for (auto it = placed.begin(); it != placed.end(); ) {
+            if (it->second.pass == pass) {
+                ++it;
+                continue;
+            }
+            vacate(view, it->second.slot);
+            it = placed.erase(it);
+        }
+
+        Airspace* h = view.header;
+        uint64_t frame = markAirspaceFrame(h);
+        airspace->endWrite();
+        announceAirspaceFrame(h);
+        return frame;
+    }
+
+    size_t aircraftCount() const { return placed.size(); }
+};
+
+#endif /* AIRSPACE_REPLAY_H_ */
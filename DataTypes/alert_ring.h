@@ -0,0 +1,156 @@
+/*
+ * alert_ring.h
+ *
+ * Bounded multi-producer queue of structured separation alerts, shared
+ * between the ComputerSystem checkers and the OperatorConsole. Producers
+ * never block: a full ring drops the alert and counts it. The console
+ * drains records in batches.
+ *
+ * Each cell carries a sequence number. A producer claims a position with
+ * a CAS on the tail, writes the record, then publishes it by setting the
+ * cell's sequence to position + 1. The consumer takes the cell once the
+ * sequence says it is published, and hands it back to producers for the
+ * next lap by setting it to position + capacity.
+ */
+
+#ifndef ALERT_RING_H_
+#define ALERT_RING_H_
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+
+#define ALERT_RING_SHM_NAME "/alert_ring"
+#define ALERT_RING_MAGIC 0x414C5254          // "ALRT"
+#define ALERT_RING_CAPACITY 1024             // power of two
+#define ALERT_DRAIN_BATCH 64
+
+enum AlertKind {
+    ALERT_LOSS_OF_SEPARATION,      // both minima breached now
+    ALERT_PREDICTED_CONFLICT       // both minima breached within the look-ahead
+};
+
+// Only transitions travel on the ring: ALERT_ONGOING is what the
+// checkers suppress
+enum AlertState {
+    ALERT_NEW,
+    ALERT_ONGOING,
+    ALERT_RESOLVED
+};
+
+enum AlertSeverity {
+    SEVERITY_ADVISORY,
+    SEVERITY_CAUTION,
+    SEVERITY_WARNING
+};
+
+// Predicted conflicts closer than this are raised as cautions
+#define ALERT_CAUTION_SEC 60.0
+
+struct AlertRecord {
+    time_t timestamp;
+    int aircraft1, aircraft2;
+    int kind;                   // AlertKind
+    int state;                  // AlertState
+    int severity;               // AlertSeverity
+    double horizontal;          // horizontal separation now, or at CPA (m)
+    double vertical;            // vertical separation now, or at CPA (m)
+    double time_to_conflict;    // seconds until loss of separation, 0 if already lost
+};
+
+struct AlertCell {
+    std::atomic<uint64_t> sequence;
+    AlertRecord record;
+};
+
+struct AlertRing {
+    uint32_t magic;                          // set last, once the cells are ready
+    alignas(64) std::atomic<uint64_t> tail;  // next position producers claim
+    alignas(64) std::atomic<uint64_t> head;  // next position the consumer takes
+    alignas(64) std::atomic<uint64_t> pushed;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> suppressed;        // duplicates the checkers did not push
+    alignas(64) AlertCell cells[ALERT_RING_CAPACITY];
+};
+
+inline AlertSeverity alertSeverity(AlertKind kind, double time_to_conflict) {
+    if (kind == ALERT_LOSS_OF_SEPARATION) return SEVERITY_WARNING;
+    return time_to_conflict < ALERT_CAUTION_SEC ? SEVERITY_CAUTION : SEVERITY_ADVISORY;
+}
+
+inline const char* alertSeverityName(int severity) {
+    switch (severity) {
+    case SEVERITY_WARNING: return "WARNING";
+    case SEVERITY_CAUTION: return "CAUTION";
+    default:               return "ADVISORY";
+    }
+}
+
+inline const char* alertStateName(int state) {
+    switch (state) {
+    case ALERT_NEW:      return "NEW";
+    case ALERT_ONGOING:  return "ONGOING";
+    default:             return "RESOLVED";
+    }
+}
+
+// Owner side, on freshly zeroed memory
+inline void initAlertRing(AlertRing* ring) {
+    ring->tail.store(0);
+    ring->head.store(0);
+    ring->pushed.store(0);
+    ring->dropped.store(0);
+    ring->suppressed.store(0);
+    for (uint64_t i = 0; i < ALERT_RING_CAPACITY; i++) {
+        ring->cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    ring->magic = ALERT_RING_MAGIC;
+}
+
+// Safe from any number of threads and processes. Returns false, and
+// counts the alert as dropped, when the consumer has fallen a whole ring
+// behind.
+inline bool pushAlert(AlertRing* ring, const AlertRecord& record) {
+    uint64_t pos = ring->tail.load(std::memory_order_relaxed);
+    while (true) {
+        AlertCell& cell = ring->cells[pos & (ALERT_RING_CAPACITY - 1)];
+        uint64_t seq = cell.sequence.load(std::memory_order_acquire);
+        int64_t diff = (int64_t)seq - (int64_t)pos;
+
+        if (diff == 0) {
+            if (ring->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.record = record;
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                ring->pushed.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        } else if (diff < 0) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = ring->tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Single consumer. Copies up to max published records into out and
+// returns how many; stops early at a cell a producer is still writing.
+inline int drainAlerts(AlertRing* ring, AlertRecord* out, int max) {
+    uint64_t pos = ring->head.load(std::memory_order_relaxed);
+    int taken = 0;
+
+    while (taken < max) {
+        AlertCell& cell = ring->cells[pos & (ALERT_RING_CAPACITY - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) break;
+
+        out[taken++] = cell.record;
+        cell.sequence.store(pos + ALERT_RING_CAPACITY, std::memory_order_release);
+        pos++;
+    }
+
+    ring->head.store(pos, std::memory_order_relaxed);
+    return taken;
+}
+
+#endif /* ALERT_RING_H_ */
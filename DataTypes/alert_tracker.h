@@ -0,0 +1,92 @@
+/*
+ * alert_tracker.h
+ *
+ * Per-pair alert lifecycle for the violation checkers. A pair is raised
+ * once when it enters conflict (new), stays quiet while the conflict
+ * persists (ongoing), and is raised again only when it clears (resolved).
+ * Clearing uses wider margins than entering, so a pair hovering at the
+ * minimum does not flap between new and resolved every cycle.
+ *
+ * One tracker belongs to one checker thread; it is not shared.
+ */
+
+#ifndef ALERT_TRACKER_H_
+#define ALERT_TRACKER_H_
+
+#include <stdint.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include "alert_ring.h"
+
+// A pair in loss of separation is resolved once it is this much beyond
+// either minimum
+#define HORIZONTAL_HYSTERESIS 500.0
+#define VERTICAL_HYSTERESIS 200.0
+
+// A predicted conflict is resolved once it no longer shows up within the
+// look-ahead extended by this much
+#define PREDICTION_HYSTERESIS_SEC 30.0
+
+class AlertTracker {
+
+private:
+    struct PairState {
+        int aircraft1, aircraft2;
+        uint32_t last_seen;     // cycle in which the pair last met the entry test
+    };
+
+    std::unordered_map<uint64_t, PairState> pairs;
+    std::vector<uint64_t> cleared;
+    uint32_t cycle = 0;
+    uint64_t suppressed = 0;
+
+    static uint64_t key(int a, int b) {
+        uint32_t lo = std::min(a, b), hi = std::max(a, b);
+        return (uint64_t)lo << 32 | hi;
+    }
+
+public:
+    void beginCycle() { cycle++; }
+
+    // The pair meets the entry test this cycle. Returns ALERT_NEW the first
+    // time, ALERT_ONGOING (a suppressed duplicate) after that.
+    AlertState observe(int aircraft1, int aircraft2) {
+        auto inserted = pairs.emplace(key(aircraft1, aircraft2),
+                                      PairState{aircraft1, aircraft2, cycle});
+        if (inserted.second) return ALERT_NEW;
+
+        inserted.first->second.last_seen = cycle;
+        suppressed++;
+        return ALERT_ONGOING;
+    }
+
+    // Settles the tracked pairs that did not meet the entry test this
+    // cycle. held(a, b) says whether the pair is still inside the wider
+    // exit margins; pairs that are not are dropped and passed to
+    // resolved(a, b).
+    template <typename Held, typename Resolved>
+    void endCycle(Held held, Resolved resolved) {
+        cleared.clear();
+        for (auto& entry : pairs) {
+            PairState& p = entry.second;
+            if (p.last_seen == cycle) continue;
+            if (held(p.aircraft1, p.aircraft2)) continue;
+
+            resolved(p.aircraft1, p.aircraft2);
+            cleared.push_back(entry.first);
+        }
+        for (uint64_t k : cleared) pairs.erase(k);
+    }
+
+    size_t activePairs() const { return pairs.size(); }
+
+    // Duplicates not emitted since the last call
+    uint64_t takeSuppressed() {
+        uint64_t n = suppressed;
+        suppressed = 0;
+        return n;
+    }
+};
+
+#endif /* ALERT_TRACKER_H_ */
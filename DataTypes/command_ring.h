@@ -0,0 +1,112 @@
+/*
+ * command_ring.h
+ *
+ * Single-producer/single-consumer queue of operator commands in shared
+ * memory. Two of them carry a command along the chain: the OperatorConsole
+ * feeds the ComputerSystem, which forwards to the CommunicationSystem.
+ * Each command is taken off a ring once, so it is forwarded exactly once.
+ *
+ * No lock: the producer only writes the tail and the consumer only writes
+ * the head, and each cursor sits on its own cache line next to the side's
+ * cached copy of the other cursor, so neither side touches the other's
+ * line until its cached view runs out. A slot is written before the tail
+ * that covers it is published, and read before the head that frees it.
+ * Every command is stamped with its sequence number on the ring.
+ *
+ * Each side can block instead of polling: a push signals not_empty and a
+ * pop signals not_full. Read the event before looking at the ring, then
+ * wait on that value, so a command pushed in between still wakes you.
+ */
+
+#ifndef COMMAND_RING_H_
+#define COMMAND_RING_H_
+
+#include <stdint.h>
+#include <atomic>
+#include "operator_command.h"
+#include "shm_event.h"
+
+#define COMMAND_RING_MAGIC 0x434D4452        // "CMDR"
+#define COMMAND_RING_CAPACITY 256            // power of two
+
+struct CommandSlot {
+    uint64_t sequence;
+    OperatorCommand command;
+};
+
+struct CommandRing {
+    uint32_t magic;                          // set last, once the ring is ready
+
+    // Producer's line
+    alignas(64) std::atomic<uint64_t> tail;  // next sequence the producer writes
+    uint64_t head_cache;                     // producer's last look at head
+    uint64_t dropped;                        // pushes refused on a full ring
+
+    // Consumer's line
+    alignas(64) std::atomic<uint64_t> head;  // next sequence the consumer takes
+    uint64_t tail_cache;                     // consumer's last look at tail
+
+    alignas(64) ShmEvent not_empty;          // signalled by the producer
+    alignas(64) ShmEvent not_full;           // signalled by the consumer
+
+    alignas(64) CommandSlot slots[COMMAND_RING_CAPACITY];
+};
+
+// Owner side, on freshly zeroed memory
+inline void initCommandRing(CommandRing* ring) {
+    ring->tail.store(0);
+    ring->head.store(0);
+    ring->head_cache = 0;
+    ring->tail_cache = 0;
+    ring->dropped = 0;
+    initShmEvent(&ring->not_empty);
+    initShmEvent(&ring->not_full);
+    std::atomic_thread_fence(std::memory_order_release);
+    ring->magic = COMMAND_RING_MAGIC;
+}
+
+// Producer only. Returns false, and counts the command as dropped, when
+// the consumer is a whole ring behind.
+inline bool pushCommand(CommandRing* ring, const OperatorCommand& command) {
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->head_cache >= COMMAND_RING_CAPACITY) {
+        ring->head_cache = ring->head.load(std::memory_order_acquire);
+        if (tail - ring->head_cache >= COMMAND_RING_CAPACITY) {
+            ring->dropped++;
+            return false;
+        }
+    }
+
+    CommandSlot& slot = ring->slots[tail & (COMMAND_RING_CAPACITY - 1)];
+    slot.sequence = tail;
+    slot.command = command;
+    ring->tail.store(tail + 1, std::memory_order_release);
+    signalShmEvent(&ring->not_empty);
+    return true;
+}
+
+// Consumer only. The oldest command not yet taken, or nullptr when the
+// ring is empty. It stays in place until popCommand(), so a consumer that
+// cannot hand it on yet can retry later without losing it.
+inline const CommandSlot* peekCommand(CommandRing* ring) {
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head == ring->tail_cache) {
+        ring->tail_cache = ring->tail.load(std::memory_order_acquire);
+        if (head == ring->tail_cache) return nullptr;
+    }
+    return &ring->slots[head & (COMMAND_RING_CAPACITY - 1)];
+}
+
+// Consumer only, after a successful peekCommand()
+inline void popCommand(CommandRing* ring) {
+    ring->head.store(ring->head.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release);
+    signalShmEvent(&ring->not_full);
+}
+
+inline uint64_t pendingCommands(const CommandRing* ring) {
+    return ring->tail.load(std::memory_order_acquire) -
+           ring->head.load(std::memory_order_acquire);
+}
+
+#endif /* COMMAND_RING_H_ */
@@ -10,18 +10,11 @@
 
 #include <pthread.h>
 #include <sys/types.h>
-#include "operator_command.h"
+#include "command_ring.h"
 
+// CommandRing from the ComputerSystem (producer) to the CommunicationSystem
+// (consumer, owner of the segment)
 #define COMMUNICATION_COMMAND_SHM_NAME "communication_commands_shm"
-#define MAX_COMMANDS 100
-
-struct CommunicationCommandMemory {
-    pthread_mutex_t lock;
-    int command_count;
-    OperatorCommand commands[MAX_COMMANDS];
-    pid_t comm_pid;
-    bool pid_ready;
-};
 
 
 #endif
@@ -0,0 +1,97 @@
+/*
+ * conflict_prediction.h
+ *
+ * Closed-form closest point of approach (CPA) between two aircraft flying
+ * straight lines. Positions are in metres and speeds in metres per second,
+ * the same units the position threads integrate with.
+ */
+
+#ifndef CONFLICT_PREDICTION_H_
+#define CONFLICT_PREDICTION_H_
+
+#include <algorithm>
+#include <cmath>
+#include "aircraft_data.h"
+#include "airspace.h"
+#include "separation.h"
+
+#define DEFAULT_LOOKAHEAD_SEC 120.0
+
+struct ConflictPrediction {
+    double tcpa;            // seconds until horizontal closest approach, within the window
+    double dcpa;            // horizontal distance at tcpa (m)
+    double dz_at_cpa;       // vertical distance at tcpa (m)
+    double time_to_los;     // seconds until both minima are breached, -1 if never in the window
+};
+
+// Dead-reckons an aircraft record forward; time is scaled by 1/3600, so
+// it is in seconds against speeds given per hour
+inline void getProjectedPosition(AircraftData& aircraft, double time) {
+    aircraft.x += aircraft.speedX * time / 3600;
+    aircraft.y += aircraft.speedY * time / 3600;
+    aircraft.z += aircraft.speedZ * time / 3600;
+}
+
+// Prediction from relative position p and relative velocity v of the pair
+inline ConflictPrediction predictRelative(double px, double py, double pz,
+                                          double vx, double vy, double vz,
+                                          double lookahead) {
+    ConflictPrediction result;
+
+    // Horizontal CPA: minimise |p + v t|^2 over [0, lookahead]
+    double vv = vx * vx + vy * vy;
+    double pv = px * vx + py * vy;
+    result.tcpa = vv > 0 ? std::min(std::max(-pv / vv, 0.0), lookahead) : 0.0;
+    double cx = px + vx * result.tcpa, cy = py + vy * result.tcpa;
+    result.dcpa = std::sqrt(cx * cx + cy * cy);
+    result.dz_at_cpa = std::fabs(pz + vz * result.tcpa);
+
+    // Interval where the horizontal minimum is breached: |p + v t|^2 < H^2
+    double h_lo, h_hi;
+    double c = px * px + py * py - HORIZONTAL_SEPARATION * HORIZONTAL_SEPARATION;
+    if (vv == 0) {
+        if (c >= 0) { result.time_to_los = -1; return result; }
+        h_lo = 0;
+        h_hi = lookahead;
+    } else {
+        double disc = pv * pv - vv * c;
+        if (disc <= 0) { result.time_to_los = -1; return result; }
+        double root = std::sqrt(disc);
+        h_lo = (-pv - root) / vv;
+        h_hi = (-pv + root) / vv;
+    }
+
+    // Interval where the vertical minimum is breached: |pz + vz t| < V
+    double v_lo, v_hi;
+    if (vz == 0) {
+        if (std::fabs(pz) >= VERTICAL_SEPARATION) { result.time_to_los = -1; return result; }
+        v_lo = 0;
+        v_hi = lookahead;
+    } else {
+        v_lo = (-VERTICAL_SEPARATION - pz) / vz;
+        v_hi = (VERTICAL_SEPARATION - pz) / vz;
+        if (v_lo > v_hi) std::swap(v_lo, v_hi);
+    }
+
+    double lo = std::max(std::max(h_lo, v_lo), 0.0);
+    double hi = std::min(std::min(h_hi, v_hi), lookahead);
+    result.time_to_los = lo < hi ? lo : -1;
+    return result;
+}
+
+// Pure function of the two records: nothing is written back, so it can be
+// run on a snapshot without disturbing the simulation.
+inline ConflictPrediction predictConflict(const AircraftData& a, const AircraftData& b,
+                                          double lookahead) {
+    return predictRelative(a.x - b.x, a.y - b.y, a.z - b.z,
+                           a.speedX - b.speedX, a.speedY - b.speedY, a.speedZ - b.speedZ,
+                           lookahead);
+}
+
+inline ConflictPrediction predictConflict(const SoAView& s, int i, int j, double lookahead) {
+    return predictRelative(s.x[i] - s.x[j], s.y[i] - s.y[j], s.z[i] - s.z[j],
+                           s.vx[i] - s.vx[j], s.vy[i] - s.vy[j], s.vz[i] - s.vz[j],
+                           lookahead);
+}
+
+#endif /* CONFLICT_PREDICTION_H_ */
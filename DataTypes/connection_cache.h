@@ -0,0 +1,188 @@
+/*
+ * connection_cache.h
+ *
+ * Keeps connections to aircraft channels open between sends, keyed by
+ * aircraft id, so a repeated command or interrogation skips the name
+ * server. Bounded: the least recently used connection is closed when the
+ * cache is full. A send that fails because the channel went away (the
+ * aircraft detached or retired) drops the cached connection and retries
+ * once on a fresh one.
+ *
+ * How a connection is opened and closed is supplied by the caller
+ * (name_open/name_close on QNX), which keeps this header free of QNX
+ * dependencies. Connections are leased: one evicted or invalidated while
+ * another thread is still sending on it is closed when that send ends.
+ */
+
+#ifndef CONNECTION_CACHE_H_
+#define CONNECTION_CACHE_H_
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+
+#define DEFAULT_CONNECTION_CACHE_SIZE 64
+
+class ConnectionCache {
+
+public:
+    typedef std::function<int(int id)> OpenFn;      // returns a connection id or -1
+    typedef std::function<void(int coid)> CloseFn;
+
+private:
+    struct Entry {
+        int coid;
+        std::list<int>::iterator lru;
+    };
+
+    OpenFn open_connection;
+    CloseFn close_connection;
+    size_t capacity;
+
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    std::unordered_map<int, Entry> entries;
+    std::list<int> lru;                          // most recently used first
+    std::unordered_map<int, int> users;          // coid -> sends in progress
+    std::unordered_set<int> dropped;             // coids to close once unused
+
+    uint64_t hit_count = 0, miss_count = 0;
+    uint64_t eviction_count = 0, invalidation_count = 0;
+
+    // Caller holds lock
+    void retire(int coid) {
+        if (users[coid] > 0) {
+            dropped.insert(coid);
+        } else {
+            users.erase(coid);
+            close_connection(coid);
+        }
+    }
+
+    // Caller holds lock
+    void erase(std::unordered_map<int, Entry>::iterator it) {
+        lru.erase(it->second.lru);
+        retire(it->second.coid);
+        entries.erase(it);
+    }
+
+public:
+    ConnectionCache(OpenFn open_fn, CloseFn close_fn,
+                    size_t capacity = DEFAULT_CONNECTION_CACHE_SIZE)
+        : open_connection(open_fn), close_connection(close_fn),
+          capacity(capacity > 0 ? capacity : 1) {}
+
+    ~ConnectionCache() { clear(); }
+
+    // Leases the connection for an aircraft, opening it on a miss.
+    // Returns -1 if it cannot be opened. Every successful acquire must
+    // be paired with release().
+    int acquire(int id) {
+        pthread_mutex_lock(&lock);
+        auto it = entries.find(id);
+        if (it != entries.end()) {
+            lru.splice(lru.begin(), lru, it->second.lru);
+            int coid = it->second.coid;
+            users[coid]++;
+            hit_count++;
+            pthread_mutex_unlock(&lock);
+            return coid;
+        }
+        miss_count++;
+        pthread_mutex_unlock(&lock);
+
+        // The name server lookup runs outside the lock
+        int coid = open_connection(id);
+        if (coid == -1) return -1;
+
+        pthread_mutex_lock(&lock);
+        it = entries.find(id);
+        if (it != entries.end()) {
+            // Another thread opened it meanwhile; keep theirs
+            int cached = it->second.coid;
+            users[cached]++;
+            pthread_mutex_unlock(&lock);
+            close_connection(coid);
+            return cached;
+        }
+
+        if (entries.size() >= capacity) {
+            erase(entries.find(lru.back()));
+            eviction_count++;
+        }
+        lru.push_front(id);
+        entries[id] = {coid, lru.begin()};
+        users[coid]++;
+        pthread_mutex_unlock(&lock);
+        return coid;
+    }
+
+    void release(int coid) {
+        pthread_mutex_lock(&lock);
+        if (--users[coid] <= 0 && dropped.erase(coid)) {
+            users.erase(coid);
+            close_connection(coid);
+        }
+        pthread_mutex_unlock(&lock);
+    }
+
+    // Drops the cached connection for an aircraft, if it is still coid
+    void invalidate(int id, int coid) {
+        pthread_mutex_lock(&lock);
+        auto it = entries.find(id);
+        if (it != entries.end() && it->second.coid == coid) {
+            erase(it);
+            invalidation_count++;
+        }
+        pthread_mutex_unlock(&lock);
+    }
+
+    void clear() {
+        pthread_mutex_lock(&lock);
+        while (!entries.empty()) erase(entries.begin());
+        pthread_mutex_unlock(&lock);
+    }
+
+    // Runs send(coid) on the cached connection. Returns send's status, or
+    // -1 if no connection could be opened. A send that fails because the
+    // channel is gone is retried once on a fresh connection.
+    template <typename Send>
+    int send(int id, Send send_fn) {
+        for (int attempt = 0; attempt < 2; attempt++) {
+            int coid = acquire(id);
+            if (coid == -1) return -1;
+
+            int status = send_fn(coid);
+            int err = errno;
+            bool stale = status == -1 && isStaleConnection(err);
+
+            // Invalidate while still holding the lease, so the number
+            // cannot have been reused by a fresh connection yet
+            if (stale) invalidate(id, coid);
+            release(coid);
+
+            if (!stale) {
+                errno = err;
+                return status;
+            }
+            errno = err;
+        }
+        return -1;
+    }
+
+    // Errors a send gets when the channel behind a connection went away
+    static bool isStaleConnection(int err) {
+        return err == EBADF || err == ESRCH || err == ENOTCONN ||
+               err == ECONNREFUSED || err == EPIPE || err == ECONNRESET;
+    }
+
+    uint64_t hits() const { return hit_count; }
+    uint64_t misses() const { return miss_count; }
+    uint64_t evictions() const { return eviction_count; }
+    uint64_t invalidations() const { return invalidation_count; }
+};
+
+#endif /* CONNECTION_CACHE_H_ */
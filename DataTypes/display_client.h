@@ -0,0 +1,133 @@
+/*
+ * display_client.h
+ *
+ * One operator position reading the display snapshots. A position claims
+ * a slot in the segment's client table, keeps its sector and altitude
+ * filter there, and moves its read cursor as it draws. Drawing waits for
+ * the next publication rather than polling on a clock, so a display shows
+ * each new picture as soon as it is out, and a slow one simply skips to
+ * the newest; the producer never waits for anybody.
+ *
+ * Positions in one process (the load test runs fifty as threads) each
+ * have their own DisplayClient and their own slot.
+ */
+
+#ifndef DISPLAY_CLIENT_H_
+#define DISPLAY_CLIENT_H_
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include "display_data.h"
+
+class DisplayClient {
+
+private:
+    DisplaySegment* segment;
+    DisplayClientSlot* slot = nullptr;
+    Viewport filter;
+    uint64_t cursor = 0;
+    uint64_t frames = 0;
+    uint64_t skipped = 0;
+    int64_t max_latency_ns = 0;
+
+    static int64_t monotonicNs() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+
+    // A slot is free if nobody holds it or its holder has exited
+    static bool claim(DisplayClientSlot& s, int32_t owner) {
+        int32_t holder = s.pid.load(std::memory_order_relaxed);
+        if (holder != 0 && (kill(holder, 0) == 0 || errno != ESRCH)) return false;
+        return s.pid.compare_exchange_strong(holder, owner, std::memory_order_acquire);
+    }
+
+public:
+    explicit DisplayClient(DisplaySegment* segment) : segment(segment) {}
+    ~DisplayClient() { detach(); }
+
+    DisplayClient(const DisplayClient&) = delete;
+    DisplayClient& operator=(const DisplayClient&) = delete;
+
+    // Takes a slot in the client table. Returns false if all
+    // DISPLAY_MAX_CLIENTS are taken; the position still draws, unlisted.
+    bool attach(int32_t owner, const Viewport& view) {
+        filter = view;
+        for (DisplayClientSlot& s : segment->clients) {
+            if (!claim(s, owner)) continue;
+            s.filter = view;
+            s.cursor.store(0, std::memory_order_relaxed);
+            s.frames.store(0, std::memory_order_relaxed);
+            s.skipped.store(0, std::memory_order_relaxed);
+            s.last_latency_ns.store(0, std::memory_order_relaxed);
+            s.max_latency_ns.store(0, std::memory_order_relaxed);
+            slot = &s;
+            return true;
+        }
+        return false;
+    }
+
+    void detach() {
+        if (slot == nullptr) return;
+        slot->pid.store(0, std::memory_order_release);
+        slot = nullptr;
+    }
+
+    const Viewport& getFilter() const { return filter; }
+
+    void setFilter(const Viewport& view) {
+        filter = view;
+        if (slot != nullptr) slot->filter = view;
+    }
+
+    bool hasNewPublication() const {
+        return segment->published_count.load(std::memory_order_acquire) != cursor;
+    }
+
+    // Blocks until there is a publication past the cursor or timeout_ms
+    // passes; returns whether there is one
+    bool waitForPublication(long timeout_ms) {
+        uint64_t seen = shmEventValue(&segment->published);
+        if (hasNewPublication()) return true;
+        waitShmEvent(&segment->published, seen, timeout_ms);
+        return hasNewPublication();
+    }
+
+    // Composes the newest publication through the filter and moves the
+    // cursor to it. Returns nanoseconds from publish to composed frame, or
+    // -1 if the publication was already drawn (a redraw after a filter
+    // change, or nothing published yet).
+    int64_t render(DisplayFrame& frame) {
+        DisplaySnapshotInfo info = readDisplaySnapshot(segment, filter, frame);
+        if (info.publication == cursor || info.publication == 0) return -1;
+
+        int64_t latency = monotonicNs() - info.published_ns;
+        if (latency < 0) latency = 0;
+        uint64_t missed = cursor == 0 ? 0 : info.publication - cursor - 1;
+        cursor = info.publication;
+        frames++;
+        skipped += missed;
+        max_latency_ns = std::max(max_latency_ns, latency);
+
+        if (slot != nullptr) {
+            slot->cursor.store(cursor, std::memory_order_relaxed);
+            slot->frames.store(frames, std::memory_order_relaxed);
+            slot->skipped.store(skipped, std::memory_order_relaxed);
+            slot->last_latency_ns.store(latency, std::memory_order_relaxed);
+            slot->max_latency_ns.store(max_latency_ns, std::memory_order_relaxed);
+        }
+        return latency;
+    }
+
+    uint64_t readCursor() const { return cursor; }
+    uint64_t framesDrawn() const { return frames; }
+    uint64_t publicationsSkipped() const { return skipped; }
+    int64_t maxLatencyNs() const { return max_latency_ns; }
+};
+
+#endif /* DISPLAY_CLIENT_H_ */
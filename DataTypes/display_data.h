@@ -1,15 +1,216 @@
 /*
  * display_data.h
  *
- *  Created on: Mar 17, 2025
- *      Author: david
+ * Display snapshots: everything a DataDisplay draws, worked out once per
+ * airspace frame by the ComputerSystem and published in a shared segment
+ * that any number of displays read without touching the airspace.
+ *
+ * A snapshot holds the detected aircraft as tracks, sorted by ScopeIndex
+ * tile and then id, with the tile starts so a viewport query visits only
+ * the tiles it overlaps. Each track carries its blip letter, its cell in
+ * the whole-airspace view and its table row already formatted; the
+ * whole-airspace grid and its table are precomputed too. A display at the
+ * default view copies them, and a zoomed one only counts cells and sorts
+ * the tracks in view.
+ *
+ * The segment holds two buffers. The producer fills the one readers are
+ * not pointed at, then flips `current` and signals `published`. Each
+ * buffer has its own sequence counter, odd while it is being written, so
+ * a reader too slow to finish before the producer comes back around to
+ * its buffer sees the count move and retries on the newer one.
+ *
+ * Each operator position claims a slot in the client table, where it keeps
+ * its sector and altitude filter and its read cursor: the last publication
+ * it drew. The slots cost the producer nothing; they let anyone see which
+ * positions are watching what, and how far behind each one is.
  */
 
 #ifndef SRC_DISPLAY_DATA_H_
 #define SRC_DISPLAY_DATA_H_
 
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "airspace_display.h"
+#include "display_viewport.h"
+#include "shm_event.h"
+
+#define DISPLAY_SHM_NAME "/display_snapshot"
+#define DISPLAY_MAGIC 0x44495350                // "DISP"
+#define DISPLAY_LAYOUT_VERSION 2
+#define DISPLAY_MAX_TRACKS 16384
+#define DISPLAY_TILE_COUNT (SCOPE_TILES * SCOPE_TILES)
+#define DISPLAY_MAX_CLIENTS 64
+
+struct DisplayTrack {
+    int32_t id;
+    int32_t vx, vy, vz;                         // m/s, as the table shows them
+    double x, y, z;                             // m
+    int16_t col, row;                           // whole-airspace cell, -1 if outside
+    char blip;
+    char row_text[DISPLAY_ROW_WIDTH];           // BLIP ID X Y Z VX VY VZ Entry LastUpdate
+};
+
+struct DisplayBuffer {
+    std::atomic<uint64_t> sequence;             // odd while the producer writes
+    uint64_t publication;                       // published_count once it is out
+    uint64_t airspace_frame;                    // frame the snapshot was taken from
+    int64_t published_ns;                       // CLOCK_MONOTONIC, for reader latency
+    time_t taken;
+    int32_t track_count;
+    int32_t dropped;                            // detected aircraft over DISPLAY_MAX_TRACKS
+    int32_t default_count;                      // tracks in the whole-airspace view
+    int32_t default_rows[DISPLAY_HEIGHT];       // its table, by id
+    char default_grid[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+    int32_t tile_start[DISPLAY_TILE_COUNT + 1];
+    DisplayTrack tracks[DISPLAY_MAX_TRACKS];    // by tile, then id
+};
+
+// Written only by the position holding it; pid is 0 while the slot is free
+struct DisplayClientSlot {
+    std::atomic<int32_t> pid;
+    Viewport filter;                            // sector and altitude band drawn
+    std::atomic<uint64_t> cursor;               // last publication drawn
+    std::atomic<uint64_t> frames;               // publications drawn
+    std::atomic<uint64_t> skipped;              // publications never drawn
+    std::atomic<uint64_t> last_latency_ns;      // publish to frame composed
+    std::atomic<uint64_t> max_latency_ns;
+};
+
+struct DisplaySegment {
+    uint32_t magic;                             // set last, once the buffers are ready
+    uint32_t layout_version;
+    std::atomic<uint32_t> current;              // buffer readers should take
+    std::atomic<uint64_t> published_count;
+    ShmEvent published;
+    DisplayClientSlot clients[DISPLAY_MAX_CLIENTS];
+    DisplayBuffer buffers[2];
+};
+
+struct DisplaySnapshotInfo {
+    uint64_t publication;
+    uint64_t airspace_frame;
+    int64_t published_ns;
+};
+
+// Owner side, on freshly zeroed memory
+inline void initDisplaySegment(DisplaySegment* segment) {
+    segment->layout_version = DISPLAY_LAYOUT_VERSION;
+    segment->current.store(0);
+    segment->published_count.store(0);
+    initShmEvent(&segment->published);
+    for (DisplayBuffer& b : segment->buffers) {
+        b.sequence.store(0);
+        memset(b.default_grid, '.', sizeof(b.default_grid));    // empty until the first publish
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->magic = DISPLAY_MAGIC;
+}
+
+// Fills the frame from a buffer. Only reads the buffer, so a reader
+// checks the buffer's sequence around it.
+inline void composeSnapshot(const DisplayBuffer& buffer, const Viewport& viewport,
+                            DisplayFrame& frame) {
+    static thread_local std::vector<int> visible;
+    char screen[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+    const int* rows;
+    int row_count, shown;
+
+    Viewport whole;
+    bool default_view = viewport.zoom == whole.zoom && viewport.center_x == whole.center_x &&
+                        viewport.center_y == whole.center_y && viewport.floor == whole.floor &&
+                        viewport.ceiling == whole.ceiling;
+
+    if (default_view) {
+        memcpy(screen, buffer.default_grid, sizeof(screen));
+        shown = buffer.default_count;
+        rows = buffer.default_rows;
+        row_count = std::max(0, std::min(shown, DISPLAY_HEIGHT));
+    } else {
+        int counts[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+        memset(screen, '.', sizeof(screen));
+        memset(counts, 0, sizeof(counts));
+        visible.clear();
+
+        double left = viewport.left(), right = viewport.right();
+        double top = viewport.top(), bottom = viewport.bottom();
+        double col_scale = DISPLAY_WIDTH / viewport.width();
+        double row_scale = DISPLAY_HEIGHT / viewport.height();
+        int x0 = ScopeIndex::tileOf(left, AIRSPACE_WIDTH);
+        int x1 = ScopeIndex::tileOf(right, AIRSPACE_WIDTH);
+        int y0 = ScopeIndex::tileOf(top, AIRSPACE_HEIGHT);
+        int y1 = ScopeIndex::tileOf(bottom, AIRSPACE_HEIGHT);
+        int limit = std::max(0, std::min((int)buffer.track_count, DISPLAY_MAX_TRACKS));
+
+        for (int ty = y0; ty <= y1; ty++) {
+            // Clamped, since a torn read is only caught after composing
+            int begin = std::max(0, std::min(buffer.tile_start[ty * SCOPE_TILES + x0], limit));
+            int end = std::min(buffer.tile_start[ty * SCOPE_TILES + x1 + 1], limit);
+            for (int k = begin; k < end; k++) {
+                const DisplayTrack& t = buffer.tracks[k];
+                if (t.x < left || t.x >= right || t.y < top || t.y >= bottom) continue;
+                if (t.z < viewport.floor || t.z > viewport.ceiling) continue;
+
+                int x = std::min(DISPLAY_WIDTH - 1, (int)((t.x - left) * col_scale));
+                int y = std::min(DISPLAY_HEIGHT - 1, (int)((t.y - top) * row_scale));
+                int n = ++counts[y][x];
+                screen[y][x] = displayCell(n, t.blip);
+                visible.push_back(k);
+            }
+        }
+
+        // The table lists the lowest ids in view
+        shown = (int)visible.size();
+        row_count = std::min(shown, DISPLAY_HEIGHT);
+        std::partial_sort(visible.begin(), visible.begin() + row_count, visible.end(),
+                          [&](int a, int b) { return buffer.tracks[a].id < buffer.tracks[b].id; });
+        rows = visible.data();
+    }
+
+    char title[64];
+    formatViewportTitle(title, sizeof(title), viewport, shown);
+    composeFrameBorders(frame, title);
+
+    for (int row = 0; row < DISPLAY_HEIGHT; ++row) {
+        char* at = frame.cells[row + 2];
+        *at++ = '|';
+        memcpy(at, screen[row], DISPLAY_WIDTH);
+        at += DISPLAY_WIDTH;
+        at = putField(at, "||   ", 5);
+        if (row < row_count) {
+            int k = rows[row];
+            if (k >= 0 && k < DISPLAY_MAX_TRACKS) {
+                memcpy(at, buffer.tracks[k].row_text, DISPLAY_ROW_WIDTH);
+            } else {
+                memset(at, ' ', DISPLAY_ROW_WIDTH);
+            }
+            at += DISPLAY_ROW_WIDTH;
+        } else {
+            at = putField(at, "", DISPLAY_ROW_WIDTH);
+        }
+        putField(at, " |", 2);
+    }
+}
 
+// Reader side: fills the frame from the newest complete snapshot, retrying
+// if the producer overwrote the buffer meanwhile. Returns which
+// publication it was drawn from.
+inline DisplaySnapshotInfo readDisplaySnapshot(DisplaySegment* segment, const Viewport& viewport,
+                                    DisplayFrame& frame) {
+    while (true) {
+        const DisplayBuffer& b = segment->buffers[segment->current.load(std::memory_order_acquire) & 1];
+        uint64_t before = b.sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
 
+        composeSnapshot(b, viewport, frame);
+        DisplaySnapshotInfo info = {b.publication, b.airspace_frame, b.published_ns};
 
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (b.sequence.load(std::memory_order_relaxed) == before) return info;
+    }
+}
 
 #endif /* SRC_DISPLAY_DATA_H_ */
@@ -0,0 +1,201 @@
+/*
+ * display_publisher.h
+ *
+ * Producer side of the display snapshots in display_data.h. Once per
+ * airspace frame it copies the detected aircraft out of the airspace,
+ * gives each a blip letter that sticks to its id, formats its table row,
+ * and writes the tracks, the tile starts and the whole-airspace grid and
+ * table into the buffer the displays are not reading. All buffers are
+ * kept between frames, so a steady-state publish does not allocate.
+ */
+
+#ifndef DISPLAY_PUBLISHER_H_
+#define DISPLAY_PUBLISHER_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "airspace.h"
+#include "active_index.h"
+#include "display_data.h"
+
+// "HH:MM:SS" without a localtime() per call. UTC offsets only change on
+// a quarter-hour boundary, so the local time of day is looked up once per
+// quarter hour; a small direct-mapped table covers the few a frame spans.
+class ClockFormatter {
+
+private:
+    struct Quarter {
+        time_t start = -1;
+        int local_seconds = 0;          // local time of day at start
+    };
+
+    Quarter quarters[16];
+
+public:
+    void format(time_t t, char text[16]) {
+        time_t start = t - ((t % 900) + 900) % 900;
+        Quarter& h = quarters[(start / 900) & 15];
+        if (h.start != start) {
+            tm local;
+            if (localtime_r(&start, &local) == nullptr) {
+                text[0] = '\0';
+                return;
+            }
+            h.start = start;
+            h.local_seconds = local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+        }
+
+        int s = (h.local_seconds + (int)(t - start)) % 86400;
+        int hh = s / 3600, mm = s / 60 % 60, ss = s % 60;
+        text[0] = '0' + hh / 10; text[1] = '0' + hh % 10; text[2] = ':';
+        text[3] = '0' + mm / 10; text[4] = '0' + mm % 10; text[5] = ':';
+        text[6] = '0' + ss / 10; text[7] = '0' + ss % 10; text[8] = '\0';
+    }
+};
+
+class DisplayPublisher {
+
+private:
+    struct Blip {
+        char letter;
+        uint64_t pass;                  // last publish that showed the aircraft
+    };
+
+    DisplaySegment* segment;
+    std::vector<AircraftData> detected;
+    std::vector<std::pair<uint64_t, int>> order;        // tile << 32 | id, index
+    std::vector<int> in_view;
+    std::unordered_map<int, Blip> blips;
+    uint64_t pass = 0;
+    uint32_t letters = 0;
+    ClockFormatter clocks;
+
+    char blipFor(int id) {
+        auto it = blips.find(id);
+        if (it == blips.end()) {
+            it = blips.emplace(id, Blip{(char)('a' + letters++ % 26), 0}).first;
+        }
+        it->second.pass = pass;
+        return it->second.letter;
+    }
+
+    // Letters of aircraft gone from the picture are forgotten
+    void forgetMissing() {
+        for (auto it = blips.begin(); it != blips.end(); ) {
+            if (it->second.pass == pass) ++it;
+            else it = blips.erase(it);
+        }
+    }
+
+public:
+    explicit DisplayPublisher(DisplaySegment* segment) : segment(segment) {}
+
+    // Takes a consistent copy of the detected aircraft, then publishes it
+    int publish(AirspaceMapping& airspace) {
+        uint64_t frame = 0;
+        airspace.read([&](const AirspaceView& view) {
+            detected.clear();
+            forEachActiveSlot(view, [&](int slot) {
+                if (view.aircraft_data[slot].detected) detected.push_back(view.aircraft_data[slot]);
+            });
+            frame = view.header->frame.load(std::memory_order_acquire);
+        });
+        return publish(detected, frame);
+    }
+
+    // Publishes the detected aircraft among the given ones and returns how
+    // many tracks the snapshot holds
+    int publish(const std::vector<AircraftData>& aircraft, uint64_t frame) {
+        pass++;
+
+        order.clear();
+        for (int i = 0; i < (int)aircraft.size(); i++) {
+            const AircraftData& a = aircraft[i];
+            if (!a.detected) continue;
+            uint64_t key = (uint64_t)ScopeIndex::tileAt(a.x, a.y) << 32 | (uint32_t)a.id;
+            order.push_back({key, i});
+        }
+        std::sort(order.begin(), order.end());
+
+        int count = std::min((int)order.size(), DISPLAY_MAX_TRACKS);
+        uint32_t which = segment->current.load(std::memory_order_relaxed) ^ 1;
+        DisplayBuffer& b = segment->buffers[which];
+
+        uint64_t seq = b.sequence.load(std::memory_order_relaxed);
+        b.sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        uint64_t publication = segment->published_count.load(std::memory_order_relaxed) + 1;
+        b.publication = publication;
+        b.airspace_frame = frame;
+        b.taken = time(NULL);
+        b.track_count = count;
+        b.dropped = (int)order.size() - count;
+
+        int counts[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+        memset(counts, 0, sizeof(counts));
+        memset(b.default_grid, '.', sizeof(b.default_grid));
+        memset(b.tile_start, 0, sizeof(b.tile_start));
+        in_view.clear();
+
+        Viewport whole;
+        char entry[16], updated[16];
+        for (int k = 0; k < count; k++) {
+            const AircraftData& a = aircraft[order[k].second];
+            DisplayTrack& t = b.tracks[k];
+            t.id = a.id;
+            t.x = a.x;
+            t.y = a.y;
+            t.z = a.z;
+            t.vx = (int32_t)a.speedX;
+            t.vy = (int32_t)a.speedY;
+            t.vz = (int32_t)a.speedZ;
+            t.blip = blipFor(a.id);
+
+            clocks.format(a.entryTime, entry);
+            clocks.format(a.lastupdatedTime, updated);
+            putTrackRow(t.row_text, t.blip, a, entry, updated);
+
+            b.tile_start[(order[k].first >> 32) + 1]++;
+
+            t.col = t.row = -1;
+            if (whole.contains(t.x, t.y, t.z)) {
+                int col, row;
+                whole.project(t.x, t.y, col, row);
+                t.col = (int16_t)col;
+                t.row = (int16_t)row;
+                b.default_grid[row][col] = displayCell(++counts[row][col], t.blip);
+                in_view.push_back(k);
+            }
+        }
+        for (int tile = 0; tile < DISPLAY_TILE_COUNT; tile++) {
+            b.tile_start[tile + 1] += b.tile_start[tile];
+        }
+
+        int rows = std::min((int)in_view.size(), DISPLAY_HEIGHT);
+        std::partial_sort(in_view.begin(), in_view.begin() + rows, in_view.end(),
+                          [&](int x, int y) { return b.tracks[x].id < b.tracks[y].id; });
+        b.default_count = (int)in_view.size();
+        for (int r = 0; r < rows; r++) b.default_rows[r] = in_view[r];
+
+        timespec done;
+        clock_gettime(CLOCK_MONOTONIC, &done);
+        b.published_ns = (int64_t)done.tv_sec * 1000000000 + done.tv_nsec;
+
+        b.sequence.store(seq + 2, std::memory_order_release);
+        segment->current.store(which, std::memory_order_release);
+        segment->published_count.store(publication, std::memory_order_release);
+        signalShmEvent(&segment->published);
+
+        forgetMissing();
+        return count;
+    }
+};
+
+#endif /* DISPLAY_PUBLISHER_H_ */
@@ -0,0 +1,121 @@
+/*
+ * display_viewport.h
+ *
+ * The part of the airspace a display shows: a rectangle around a centre
+ * point, zoomed in from the whole AIRSPACE_WIDTH x AIRSPACE_HEIGHT, and an
+ * altitude band. The operator moves it with display commands that never
+ * leave the display process (zoom, pan, center, alt, reset).
+ */
+
+#ifndef DISPLAY_VIEWPORT_H_
+#define DISPLAY_VIEWPORT_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include "radar_coverage.h"
+
+#define AIRSPACE_WIDTH 100000
+#define AIRSPACE_HEIGHT 100000
+#define DISPLAY_WIDTH 50
+#define DISPLAY_HEIGHT 14
+#define MAX_VIEWPORT_ZOOM 64.0
+#define SCOPE_TILES 64                  // per axis, about 1.6 km each
+
+struct Viewport {
+    double center_x = AIRSPACE_WIDTH / 2.0;
+    double center_y = AIRSPACE_HEIGHT / 2.0;
+    double zoom = 1.0;                  // 1 shows the whole airspace
+    double floor = RADAR_FLOOR;
+    double ceiling = RADAR_CEILING;
+
+    double width() const { return AIRSPACE_WIDTH / zoom; }
+    double height() const { return AIRSPACE_HEIGHT / zoom; }
+    double left() const { return center_x - width() / 2; }
+    double top() const { return center_y - height() / 2; }
+    double right() const { return left() + width(); }
+    double bottom() const { return top() + height(); }
+
+    bool contains(double x, double y, double z) const {
+        return x >= left() && x < right() && y >= top() && y < bottom() &&
+               z >= floor && z <= ceiling;
+    }
+
+    // Grid cell of a position inside the viewport
+    void project(double x, double y, int& col, int& row) const {
+        col = std::min(DISPLAY_WIDTH - 1, (int)((x - left()) / width() * DISPLAY_WIDTH));
+        row = std::min(DISPLAY_HEIGHT - 1, (int)((y - top()) / height() * DISPLAY_HEIGHT));
+    }
+
+    void setZoom(double z) {
+        zoom = std::max(1.0, std::min(z, MAX_VIEWPORT_ZOOM));
+    }
+
+    // The centre stays over the airspace, so the view never goes blank
+    void moveTo(double x, double y) {
+        center_x = std::max(0.0, std::min(x, (double)AIRSPACE_WIDTH));
+        center_y = std::max(0.0, std::min(y, (double)AIRSPACE_HEIGHT));
+    }
+};
+
+// Applies a display command to the viewport. Returns false if the line is
+// not one, so it can go to the operator console instead:
+//   zoom in | zoom out | zoom <factor>
+//   pan <dx km> <dy km>        center <x km> <y km>
+//   alt <floor m> <ceiling m>  reset
+inline bool parseViewportCommand(const std::string& line, Viewport& viewport) {
+    std::istringstream iss(line);
+    std::string word;
+    iss >> word;
+
+    if (word == "zoom") {
+        std::string arg;
+        iss >> arg;
+        if (arg == "in") {
+            viewport.setZoom(viewport.zoom * 2);
+        } else if (arg == "out") {
+            viewport.setZoom(viewport.zoom / 2);
+        } else {
+            viewport.setZoom(atof(arg.c_str()));
+        }
+    } else if (word == "pan") {
+        double dx = 0, dy = 0;
+        iss >> dx >> dy;
+        viewport.moveTo(viewport.center_x + dx * 1000, viewport.center_y + dy * 1000);
+    } else if (word == "center") {
+        double x = 0, y = 0;
+        if (!(iss >> x >> y)) return true;
+        viewport.moveTo(x * 1000, y * 1000);
+    } else if (word == "alt") {
+        double floor = 0, ceiling = 0;
+        if (!(iss >> floor >> ceiling) || floor > ceiling) return true;
+        viewport.floor = floor;
+        viewport.ceiling = ceiling;
+    } else if (word == "reset") {
+        viewport = Viewport();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Tiles of a fixed SCOPE_TILES x SCOPE_TILES grid over the airspace. The
+// display snapshot keeps its tracks sorted by tile, so a viewport only
+// reads the tiles it overlaps.
+struct ScopeIndex {
+
+    // Tile column (or row) of a coordinate; outside the airspace counts as
+    // the edge tile
+    static int tileOf(double v, double extent) {
+        int t = (int)(v / extent * SCOPE_TILES);
+        return std::max(0, std::min(t, SCOPE_TILES - 1));
+    }
+
+    static int tileAt(double x, double y) {
+        return tileOf(y, AIRSPACE_HEIGHT) * SCOPE_TILES + tileOf(x, AIRSPACE_WIDTH);
+    }
+};
+
+#endif /* DISPLAY_VIEWPORT_H_ */
@@ -0,0 +1,572 @@
+/*
+ * flight_recorder.h
+ *
+ * Binary flight recorder: every radar sweep becomes one frame in a
+ * memory-mapped file. The file is a bounded ring, so the oldest frames are
+ * overwritten once it is full, and an index maps frame numbers to their
+ * place in the ring.
+ *
+ * File layout:  RecorderHeader | FrameIndexEntry[index_capacity] | data ring
+ * Frame layout: FrameHeader | FlightRecord[record_count]
+ *
+ * Records are fixed size and quantized (cm, cm/s). A keyframe holds an
+ * absolute record for every aircraft. A delta frame holds records only
+ * for aircraft that did not fly as predicted: the prediction is the
+ * previous position advanced by the previous velocity over the frame's
+ * dt, and the record carries the residual and the velocity change.
+ * Aircraft flying straight within the position tolerance cost nothing.
+ * The encoder predicts from the same quantized state the decoder
+ * rebuilds, so replayed positions stay within the tolerance of what was
+ * recorded and error never accumulates; velocities and status are exact.
+ *
+ * The oldest frame kept is always a keyframe: when overwriting would
+ * orphan the deltas of the last keyframe, the new frame is written as a
+ * keyframe instead. Readers may open the file while it is recorded; a
+ * frame copied while it was being overwritten is detected and refused.
+ */
+
+#ifndef FLIGHT_RECORDER_H_
+#define FLIGHT_RECORDER_H_
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#define FLIGHT_RECORDER_PATH "/tmp/flight_recorder.bin"
+#define FLIGHT_RECORDER_MAGIC 0x46524543          // "FREC"
+#define FLIGHT_RECORDER_VERSION 1
+#define DEFAULT_RECORDER_DATA_BYTES (64u << 20)
+#define DEFAULT_RECORDER_INDEX_FRAMES 65536       // about 18 h at 1 Hz
+#define DEFAULT_KEYFRAME_INTERVAL 60
+#define DEFAULT_POSITION_TOLERANCE_CM 500         // sweep jitter at 400 m/s is a few m
+
+// FlightRecord::flags
+#define RECORD_ABSOLUTE   0x01      // position and velocity are absolute
+#define RECORD_DELTA      0x02      // residual against the prediction
+#define RECORD_REMOVED    0x04      // aircraft left the slot
+#define CONTACT_DETECTED  0x10      // inside the radar volume
+#define CONTACT_RESPONDED 0x20      // answered secondary radar
+#define CONTACT_STATUS_MASK (CONTACT_DETECTED | CONTACT_RESPONDED)
+
+// FrameHeader::flags and FrameIndexEntry::flags
+#define FRAME_KEYFRAME 0x01
+
+// One aircraft as the recorder takes it in and the reader hands it back
+struct RecordedAircraft {
+    int slot;
+    int id;
+    double x, y, z;
+    double vx, vy, vz;
+    uint32_t status;            // CONTACT_* bits
+};
+
+struct FlightRecord {
+    int32_t slot;
+    int32_t id;
+    uint32_t flags;
+    int32_t pos[3];             // cm
+    int32_t vel[3];             // cm/s
+};
+
+struct FrameHeader {
+    uint64_t frame;
+    int64_t timestamp_ns;       // CLOCK_REALTIME
+    uint32_t dt_ms;             // since the previous frame
+    uint32_t flags;
+    uint32_t record_count;
+    uint32_t aircraft_count;
+};
+
+struct FrameIndexEntry {
+    uint64_t frame;
+    uint64_t offset;            // into the data ring
+    uint32_t length;
+    uint32_t flags;
+    int64_t timestamp_ns;
+};
+
+struct RecorderHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t data_bytes;
+    uint32_t index_capacity;
+    uint32_t keyframe_interval;
+    uint32_t tolerance_cm;
+    std::atomic<uint64_t> end_frame;      // frames [oldest_frame, end_frame) are readable
+    std::atomic<uint64_t> oldest_frame;
+    uint64_t data_head;                   // writer only
+    uint64_t last_keyframe;               // writer only
+    uint64_t dropped;                     // frames larger than the ring
+};
+
+inline size_t recorderFileSize(uint64_t data_bytes, uint32_t index_capacity) {
+    return sizeof(RecorderHeader) + index_capacity * sizeof(FrameIndexEntry) + data_bytes;
+}
+
+// Rounds half away from zero; branch-free, since velocity signs are
+// random and a mispredicted branch costs more than the arithmetic
+inline int32_t quantizeCm(double meters) {
+    double cm = meters * 100.0;
+    return (int32_t)(cm + std::copysign(0.5, cm));
+}
+
+// Where a constant-velocity aircraft is after dt; the encoder and the
+// decoder must agree on it exactly
+inline int32_t predictCm(int32_t pos, int32_t vel, uint32_t dt_ms) {
+    return pos + (int32_t)((int64_t)vel * dt_ms / 1000);
+}
+
+// Quantized state of the aircraft in each slot, as of the last frame
+class FlightState {
+
+public:
+    struct Slot {
+        bool present;
+        bool listed;                      // in present[], possibly stale
+        int32_t id;
+        uint32_t status;
+        int32_t pos[3];
+        int32_t vel[3];
+    };
+
+    std::vector<Slot> slots;
+    std::vector<int> present;             // slots holding an aircraft
+
+    void reset() {
+        for (int s : present) slots[s].present = slots[s].listed = false;
+        present.clear();
+    }
+
+    // Marks a slot occupied, listing it once
+    void occupy(int slot) {
+        Slot& s = at(slot);
+        s.present = true;
+        if (!s.listed) {
+            s.listed = true;
+            present.push_back(slot);
+        }
+    }
+
+    Slot& at(int slot) {
+        if ((size_t)slot >= slots.size()) slots.resize(slot + 1, Slot{});
+        return slots[slot];
+    }
+
+    // Decoder side: advance every aircraft, then apply the frame's records
+    void apply(const FrameHeader& frame, const FlightRecord* records) {
+        if (frame.flags & FRAME_KEYFRAME) {
+            reset();
+        } else {
+            for (int s : present) {
+                for (int k = 0; k < 3; k++) {
+                    slots[s].pos[k] = predictCm(slots[s].pos[k], slots[s].vel[k], frame.dt_ms);
+                }
+            }
+        }
+
+        for (uint32_t r = 0; r < frame.record_count; r++) {
+            const FlightRecord& rec = records[r];
+            if (rec.slot < 0 || rec.slot >= (1 << 24)) continue;
+            Slot& s = at(rec.slot);
+
+            if (rec.flags & RECORD_REMOVED) {
+                s.present = false;
+                continue;
+            }
+            if (rec.flags & RECORD_ABSOLUTE) {
+                occupy(rec.slot);
+                s.id = rec.id;
+                for (int k = 0; k < 3; k++) {
+                    s.pos[k] = rec.pos[k];
+                    s.vel[k] = rec.vel[k];
+                }
+            } else if (s.present) {
+                for (int k = 0; k < 3; k++) {
+                    s.pos[k] += rec.pos[k];
+                    s.vel[k] += rec.vel[k];
+                }
+            }
+            s.status = rec.flags & CONTACT_STATUS_MASK;
+        }
+
+        compact();
+    }
+
+    void compact() {
+        size_t kept = 0;
+        for (int s : present) {
+            if (slots[s].present) present[kept++] = s;
+            else slots[s].listed = false;
+        }
+        present.resize(kept);
+    }
+
+    void snapshot(std::vector<RecordedAircraft>& out) const {
+        out.clear();
+        for (int s : present) {
+            const Slot& a = slots[s];
+            out.push_back({s, a.id,
+                           a.pos[0] / 100.0, a.pos[1] / 100.0, a.pos[2] / 100.0,
+                           a.vel[0] / 100.0, a.vel[1] / 100.0, a.vel[2] / 100.0,
+                           a.status});
+        }
+    }
+};
+
+class FlightRecorder {
+
+private:
+    int fd = -1;
+    void* base = nullptr;
+    size_t mapped = 0;
+    RecorderHeader* header = nullptr;
+    FrameIndexEntry* index = nullptr;
+    uint8_t* data = nullptr;
+
+    FlightState state;
+    std::vector<FlightRecord> records;
+    std::vector<uint64_t> seen;           // frame that last saw each slot
+    int64_t last_ns = 0;
+    int32_t tolerance_cm = 0;
+
+    // First frame that survives writing size bytes at offset (wrapping
+    // from old_head when wrapped), before the keyframe adjustment
+    uint64_t survivor(uint64_t offset, uint64_t size, bool wrapped, uint64_t old_head) const {
+        uint64_t end = header->end_frame.load(std::memory_order_relaxed);
+        uint64_t oldest = header->oldest_frame.load(std::memory_order_relaxed);
+        if (end - oldest >= header->index_capacity) oldest = end - header->index_capacity + 1;
+
+        while (oldest < end) {
+            const FrameIndexEntry& e = index[oldest % header->index_capacity];
+            bool overwritten = (wrapped && e.offset >= old_head) ||
+                               (e.offset < offset + size && offset < e.offset + e.length);
+            if (!overwritten) break;
+            oldest++;
+        }
+        return oldest;
+    }
+
+    void put(int slot, int id, uint32_t flags, const int32_t* pos, const int32_t* vel) {
+        FlightRecord r;
+        r.slot = slot;
+        r.id = id;
+        r.flags = flags;
+        memcpy(r.pos, pos, sizeof(r.pos));
+        memcpy(r.vel, vel, sizeof(r.vel));
+        records.push_back(r);
+    }
+
+public:
+    ~FlightRecorder() { close(); }
+
+    // Starts a fresh recording, replacing any file at path. The old file
+    // is unlinked rather than truncated, so a reader still replaying it
+    // keeps its frames.
+    bool create(const char* path,
+                uint64_t data_bytes = DEFAULT_RECORDER_DATA_BYTES,
+                uint32_t index_capacity = DEFAULT_RECORDER_INDEX_FRAMES,
+                uint32_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL,
+                uint32_t position_tolerance_cm = DEFAULT_POSITION_TOLERANCE_CM) {
+        unlink(path);
+        fd = open(path, O_CREAT | O_RDWR | O_TRUNC, 0644);
+        if (fd == -1) {
+            perror("[FlightRecorder] open failed");
+            return false;
+        }
+
+        mapped = recorderFileSize(data_bytes, index_capacity);
+        if (ftruncate(fd, mapped) == -1) {
+            perror("[FlightRecorder] ftruncate failed");
+            close();
+            return false;
+        }
+
+        base = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            perror("[FlightRecorder] mmap failed");
+            base = nullptr;
+            close();
+            return false;
+        }
+
+        header = static_cast<RecorderHeader*>(base);
+        index = reinterpret_cast<FrameIndexEntry*>(header + 1);
+        data = reinterpret_cast<uint8_t*>(index + index_capacity);
+
+        header->version = FLIGHT_RECORDER_VERSION;
+        header->data_bytes = data_bytes;
+        header->index_capacity = index_capacity;
+        header->keyframe_interval = std::max<uint32_t>(1, std::min(keyframe_interval, index_capacity / 2));
+        header->tolerance_cm = position_tolerance_cm;
+        tolerance_cm = position_tolerance_cm;
+        header->end_frame.store(0);
+        header->oldest_frame.store(0);
+        header->data_head = 0;
+        header->last_keyframe = 0;
+        header->dropped = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = FLIGHT_RECORDER_MAGIC;
+        return true;
+    }
+
+    // Appends one frame. Returns false if the recorder is not open or the
+    // frame could not fit in the ring.
+    // timestamp_ns is when the positions were sampled (CLOCK_REALTIME);
+    // 0 means now.
+    bool record(const std::vector<RecordedAircraft>& aircraft, int64_t timestamp_ns = 0) {
+        if (header == nullptr) return false;
+
+        int64_t now_ns = timestamp_ns;
+        if (now_ns == 0) {
+            timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            now_ns = (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+        }
+
+        uint64_t frame = header->end_frame.load(std::memory_order_relaxed);
+        uint32_t dt_ms = frame == 0 ? 0 : (uint32_t)std::max<int64_t>(0, (now_ns - last_ns) / 1000000);
+
+        // Size the frame for the worst case first, to know whether the
+        // write would orphan the last keyframe's deltas
+        uint64_t bound = sizeof(FrameHeader) +
+                         (state.present.size() + aircraft.size()) * sizeof(FlightRecord);
+        if (bound > header->data_bytes) {
+            header->dropped++;
+            return false;
+        }
+        bool wrapped = header->data_head + bound > header->data_bytes;
+        uint64_t offset = wrapped ? 0 : header->data_head;
+
+        bool keyframe = frame == 0 ||
+                        frame - header->last_keyframe >= header->keyframe_interval ||
+                        survivor(offset, bound, wrapped, header->data_head) > header->last_keyframe;
+
+        records.clear();
+        if (keyframe) state.reset();
+        if (seen.size() < state.slots.size()) seen.resize(state.slots.size(), UINT64_MAX);
+
+        for (const RecordedAircraft& a : aircraft) {
+            int32_t pos[3] = {quantizeCm(a.x), quantizeCm(a.y), quantizeCm(a.z)};
+            int32_t vel[3] = {quantizeCm(a.vx), quantizeCm(a.vy), quantizeCm(a.vz)};
+            uint32_t status = a.status & CONTACT_STATUS_MASK;
+
+            FlightState::Slot& s = state.at(a.slot);
+            if (seen.size() < state.slots.size()) seen.resize(state.slots.size(), UINT64_MAX);
+            seen[a.slot] = frame;
+
+            if (!s.present || s.id != a.id) {
+                if (s.present) put(a.slot, s.id, RECORD_REMOVED, s.pos, s.vel);
+                state.occupy(a.slot);
+                put(a.slot, a.id, RECORD_ABSOLUTE | status, pos, vel);
+            } else {
+                int32_t predicted[3], residual[3], dv[3];
+                bool moved = false;
+                for (int k = 0; k < 3; k++) {
+                    predicted[k] = predictCm(s.pos[k], s.vel[k], dt_ms);
+                    residual[k] = pos[k] - predicted[k];
+                    dv[k] = vel[k] - s.vel[k];
+                    moved |= residual[k] > tolerance_cm || residual[k] < -tolerance_cm || dv[k] != 0;
+                }
+                if (moved || status != s.status) {
+                    put(a.slot, a.id, RECORD_DELTA | status, residual, dv);
+                } else {
+                    // Not recorded: keep what the decoder will have
+                    memcpy(pos, predicted, sizeof(pos));
+                }
+            }
+
+            s.id = a.id;
+            s.status = status;
+            memcpy(s.pos, pos, sizeof(pos));
+            memcpy(s.vel, vel, sizeof(vel));
+        }
+
+        // Aircraft gone since the last frame
+        for (int slot : state.present) {
+            FlightState::Slot& s = state.slots[slot];
+            if (s.present && seen[slot] != frame) {
+                put(slot, s.id, RECORD_REMOVED, s.pos, s.vel);
+                s.present = false;
+            }
+        }
+        state.compact();
+
+        uint64_t size = sizeof(FrameHeader) + records.size() * sizeof(FlightRecord);
+
+        // Retire what the write covers before touching the bytes, then
+        // keep the oldest readable frame on a keyframe
+        uint64_t oldest = survivor(offset, size, wrapped, header->data_head);
+        while (oldest < frame && !(index[oldest % header->index_capacity].flags & FRAME_KEYFRAME)) {
+            oldest++;
+        }
+        header->oldest_frame.store(oldest, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        FrameHeader fh = {frame, now_ns, dt_ms, keyframe ? (uint32_t)FRAME_KEYFRAME : 0u,
+                          (uint32_t)records.size(), (uint32_t)aircraft.size()};
+        memcpy(data + offset, &fh, sizeof(fh));
+        if (!records.empty()) {
+            memcpy(data + offset + sizeof(fh), records.data(), records.size() * sizeof(FlightRecord));
+        }
+
+        index[frame % header->index_capacity] = {frame, offset, (uint32_t)size, fh.flags, now_ns};
+        header->data_head = offset + size;
+        if (keyframe) header->last_keyframe = frame;
+        header->end_frame.store(frame + 1, std::memory_order_release);
+
+        last_ns = now_ns;
+        return true;
+    }
+
+    uint64_t frames() const { return header ? header->end_frame.load() : 0; }
+    uint64_t dataHead() const { return header ? header->data_head : 0; }
+
+    void close() {
+        if (base != nullptr) {
+            munmap(base, mapped);
+            base = nullptr;
+        }
+        if (fd != -1) {
+            ::close(fd);
+            fd = -1;
+        }
+        header = nullptr;
+    }
+};
+
+// Reads frames back, from a finished recording or one still being written
+class FlightRecording {
+
+private:
+    int fd = -1;
+    void* base = nullptr;
+    size_t mapped = 0;
+    const RecorderHeader* header = nullptr;
+    const FrameIndexEntry* index = nullptr;
+    const uint8_t* data = nullptr;
+
+    FlightState state;
+    uint64_t decoded = UINT64_MAX;        // frame the state is at
+    std::vector<uint8_t> scratch;
+    FrameHeader last_header = {};
+
+    // Copies one frame out of the ring; fails if it is no longer there
+    bool copyFrame(uint64_t frame) {
+        if (frame < firstFrame() || frame >= endFrame()) return false;
+
+        FrameIndexEntry e = index[frame % header->index_capacity];
+        if (e.frame != frame || e.length < sizeof(FrameHeader) ||
+            e.offset + e.length > header->data_bytes) return false;
+
+        scratch.resize(e.length);
+        memcpy(scratch.data(), data + e.offset, e.length);
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // The writer retires frames before overwriting them
+        if (frame < header->oldest_frame.load(std::memory_order_acquire)) return false;
+
+        const FrameHeader* fh = reinterpret_cast<const FrameHeader*>(scratch.data());
+        return fh->frame == frame &&
+               sizeof(FrameHeader) + (uint64_t)fh->record_count * sizeof(FlightRecord) <= e.length;
+    }
+
+    bool applyFrame(uint64_t frame) {
+        if (!copyFrame(frame)) return false;
+        const FrameHeader* fh = reinterpret_cast<const FrameHeader*>(scratch.data());
+        state.apply(*fh, reinterpret_cast<const FlightRecord*>(fh + 1));
+        last_header = *fh;
+        decoded = frame;
+        return true;
+    }
+
+public:
+    ~FlightRecording() { close(); }
+
+    bool open(const char* path) {
+        fd = ::open(path, O_RDONLY);
+        if (fd == -1) {
+            perror("[FlightRecording] open failed");
+            return false;
+        }
+
+        RecorderHeader probe;
+        if (pread(fd, &probe, sizeof(probe), 0) != (ssize_t)sizeof(probe) ||
+            probe.magic != FLIGHT_RECORDER_MAGIC || probe.version != FLIGHT_RECORDER_VERSION) {
+            fprintf(stderr, "[FlightRecording] %s is not a flight recording\n", path);
+            close();
+            return false;
+        }
+
+        mapped = recorderFileSize(probe.data_bytes, probe.index_capacity);
+        base = mmap(NULL, mapped, PROT_READ, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            perror("[FlightRecording] mmap failed");
+            base = nullptr;
+            close();
+            return false;
+        }
+
+        header = static_cast<const RecorderHeader*>(base);
+        index = reinterpret_cast<const FrameIndexEntry*>(header + 1);
+        data = reinterpret_cast<const uint8_t*>(index + header->index_capacity);
+        return true;
+    }
+
+    uint64_t firstFrame() const { return header->oldest_frame.load(std::memory_order_acquire); }
+    uint64_t endFrame() const { return header->end_frame.load(std::memory_order_acquire); }
+
+    // Index entry of a readable frame
+    bool frameInfo(uint64_t frame, FrameIndexEntry& out) const {
+        if (frame < firstFrame() || frame >= endFrame()) return false;
+        out = index[frame % header->index_capacity];
+        return out.frame == frame;
+    }
+
+    // Rebuilds every aircraft as of frame. Reading frames in order decodes
+    // one frame each; a jump replays from the nearest keyframe before it.
+    bool readFrame(uint64_t frame, std::vector<RecordedAircraft>& out, FrameHeader* info = nullptr) {
+        bool ok;
+        if (decoded != UINT64_MAX && frame == decoded) {
+            ok = true;
+        } else if (decoded != UINT64_MAX && frame == decoded + 1) {
+            ok = applyFrame(frame);
+        } else {
+            uint64_t key = frame;
+            FrameIndexEntry e;
+            while (frameInfo(key, e) && !(e.flags & FRAME_KEYFRAME) && key > firstFrame()) key--;
+
+            ok = frameInfo(key, e) && (e.flags & FRAME_KEYFRAME);
+            for (uint64_t f = key; ok && f <= frame; f++) ok = applyFrame(f);
+        }
+
+        if (!ok) {
+            decoded = UINT64_MAX;
+            return false;
+        }
+        state.snapshot(out);
+        if (info != nullptr) *info = last_header;
+        return true;
+    }
+
+    void close() {
+        if (base != nullptr) {
+            munmap(base, mapped);
+            base = nullptr;
+        }
+        if (fd != -1) {
+            ::close(fd);
+            fd = -1;
+        }
+        header = nullptr;
+    }
+};
+
+#endif /* FLIGHT_RECORDER_H_ */
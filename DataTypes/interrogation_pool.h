@@ -0,0 +1,199 @@
+/*
+ * interrogation_pool.h
+ *
+ * Secondary-radar interrogations run on a fixed set of worker threads,
+ * fed by a queue of aircraft ids, so a detection sweep only enqueues and
+ * never waits on an aircraft's IPC channel.
+ *
+ * Every request carries a deadline. A worker that picks up a request past
+ * its deadline completes it as timed out without sending; the interrogate
+ * function is expected to give up at the deadline as well. The number of
+ * requests queued or running is bounded, and an aircraft with a request
+ * already outstanding is not queued again, so a sweep that keeps seeing
+ * the same silent aircraft does not pile up work. Each request ends in
+ * exactly one call to the completion callback, on the worker thread.
+ *
+ * How an aircraft is interrogated is supplied by the caller (name_open and
+ * MsgSend on QNX), which keeps this header free of QNX dependencies.
+ */
+
+#ifndef INTERROGATION_POOL_H_
+#define INTERROGATION_POOL_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+#include <deque>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+#include "slot_allocator.h"
+
+#define DEFAULT_INTERROGATION_WORKERS 4
+#define DEFAULT_MAX_IN_FLIGHT 32
+#define DEFAULT_INTERROGATION_TIMEOUT_MS 2000
+
+enum InterrogationOutcome {
+    INTERROGATION_REPLIED,
+    INTERROGATION_FAILED,
+    INTERROGATION_TIMED_OUT
+};
+
+struct InterrogationRequest {
+    int aircraft_id;
+    SlotHandle slot;            // slot the aircraft held when it was queued
+    timespec deadline;          // CLOCK_MONOTONIC
+};
+
+class InterrogationPool {
+
+public:
+    typedef std::function<InterrogationOutcome(const InterrogationRequest&)> InterrogateFn;
+    typedef std::function<void(const InterrogationRequest&, InterrogationOutcome)> CompleteFn;
+
+private:
+    InterrogateFn interrogate;
+    CompleteFn complete;
+    int worker_count;
+    size_t max_in_flight;
+    long timeout_ms;
+
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t work = PTHREAD_COND_INITIALIZER;
+    std::deque<InterrogationRequest> queue;
+    std::unordered_set<int> outstanding;    // aircraft ids queued or running
+    std::vector<pthread_t> workers;
+    bool running = false;
+
+    uint64_t replied_count = 0, failed_count = 0;
+    uint64_t timed_out_count = 0, rejected_count = 0;
+
+    static void* workerThread(void* arg) {
+        static_cast<InterrogationPool*>(arg)->runWorker();
+        return nullptr;
+    }
+
+    void runWorker() {
+        while (true) {
+            pthread_mutex_lock(&lock);
+            while (running && queue.empty()) pthread_cond_wait(&work, &lock);
+            if (!running) {
+                pthread_mutex_unlock(&lock);
+                return;
+            }
+            InterrogationRequest request = queue.front();
+            queue.pop_front();
+            pthread_mutex_unlock(&lock);
+
+            InterrogationOutcome outcome = remainingMs(request.deadline) > 0
+                ? interrogate(request)
+                : INTERROGATION_TIMED_OUT;
+            complete(request, outcome);
+
+            pthread_mutex_lock(&lock);
+            outstanding.erase(request.aircraft_id);
+            switch (outcome) {
+            case INTERROGATION_REPLIED:   replied_count++;   break;
+            case INTERROGATION_FAILED:    failed_count++;    break;
+            case INTERROGATION_TIMED_OUT: timed_out_count++; break;
+            }
+            pthread_mutex_unlock(&lock);
+        }
+    }
+
+public:
+    InterrogationPool(InterrogateFn interrogate_fn, CompleteFn complete_fn,
+                      int workers = DEFAULT_INTERROGATION_WORKERS,
+                      size_t max_in_flight = DEFAULT_MAX_IN_FLIGHT,
+                      long timeout_ms = DEFAULT_INTERROGATION_TIMEOUT_MS)
+        : interrogate(interrogate_fn), complete(complete_fn),
+          worker_count(workers > 0 ? workers : 1),
+          max_in_flight(max_in_flight > 0 ? max_in_flight : 1),
+          timeout_ms(timeout_ms) {}
+
+    ~InterrogationPool() { stop(); }
+
+    void start() {
+        pthread_mutex_lock(&lock);
+        if (running) {
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+        running = true;
+        pthread_mutex_unlock(&lock);
+
+        workers.resize(worker_count);
+        for (pthread_t& t : workers) pthread_create(&t, NULL, workerThread, this);
+    }
+
+    // Waits for running interrogations to finish; queued ones are dropped
+    // without a completion
+    void stop() {
+        pthread_mutex_lock(&lock);
+        if (!running) {
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+        running = false;
+        queue.clear();
+        pthread_cond_broadcast(&work);
+        pthread_mutex_unlock(&lock);
+
+        for (pthread_t& t : workers) pthread_join(t, NULL);
+        workers.clear();
+        outstanding.clear();
+    }
+
+    // Never blocks on IPC. Returns false if the aircraft already has a
+    // request outstanding or the pool is at its in-flight bound.
+    bool submit(int aircraft_id, SlotHandle slot) {
+        InterrogationRequest request = {aircraft_id, slot, deadlineIn(timeout_ms)};
+
+        pthread_mutex_lock(&lock);
+        bool accepted = running && outstanding.size() < max_in_flight &&
+                        outstanding.insert(aircraft_id).second;
+        if (accepted) {
+            queue.push_back(request);
+            pthread_cond_signal(&work);
+        } else if (running && !outstanding.count(aircraft_id)) {
+            rejected_count++;
+        }
+        pthread_mutex_unlock(&lock);
+        return accepted;
+    }
+
+    size_t inFlight() {
+        pthread_mutex_lock(&lock);
+        size_t n = outstanding.size();
+        pthread_mutex_unlock(&lock);
+        return n;
+    }
+
+    uint64_t replied() const { return replied_count; }
+    uint64_t failed() const { return failed_count; }
+    uint64_t timedOut() const { return timed_out_count; }
+    uint64_t rejected() const { return rejected_count; }
+
+    static timespec deadlineIn(long ms) {
+        timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        t.tv_sec += ms / 1000;
+        t.tv_nsec += (ms % 1000) * 1000000L;
+        if (t.tv_nsec >= 1000000000L) {
+            t.tv_sec++;
+            t.tv_nsec -= 1000000000L;
+        }
+        return t;
+    }
+
+    // Milliseconds left until the deadline, 0 once it has passed
+    static long remainingMs(const timespec& deadline) {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long ms = (deadline.tv_sec - now.tv_sec) * 1000L +
+                  (deadline.tv_nsec - now.tv_nsec) / 1000000L;
+        return ms > 0 ? ms : 0;
+    }
+};
+
+#endif /* INTERROGATION_POOL_H_ */
@@ -0,0 +1,117 @@
+/*
+ * latency_histogram.h
+ *
+ * HDR-style histogram of durations in nanoseconds. Values below 128 ns
+ * get a bucket each; above that every power of two is split into 64
+ * buckets, so a bucket is never wider than 1/64 (1.6%) of the values it
+ * holds, from 1 ns up to LATENCY_MAX_NS.
+ *
+ * record() is a handful of relaxed atomic increments and never blocks,
+ * so any number of threads can record into one histogram while another
+ * takes snapshots of it. A snapshot is not an atomic cut across the
+ * buckets; a sample recorded during it may be counted in one field and
+ * not another, which is noise at the percentiles reported.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <cmath>
+#include <atomic>
+
+#define LATENCY_SUB_BITS 6
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)           // buckets per power of two
+#define LATENCY_MAX_SHIFT 34                                // up to 2^41 ns, about 36 min
+#define LATENCY_BUCKETS ((LATENCY_MAX_SHIFT + 2) * LATENCY_SUB_COUNT)
+#define LATENCY_MAX_NS ((((uint64_t)2 * LATENCY_SUB_COUNT) << LATENCY_MAX_SHIFT) - 1)
+
+inline int latencyBucket(uint64_t ns) {
+    if (ns > LATENCY_MAX_NS) ns = LATENCY_MAX_NS;
+    if (ns < 2 * LATENCY_SUB_COUNT) return (int)ns;
+    int shift = 63 - __builtin_clzll(ns) - LATENCY_SUB_BITS;
+    return shift * LATENCY_SUB_COUNT + (int)(ns >> shift);
+}
+
+// Largest value that lands in the bucket
+inline uint64_t latencyBucketLimit(int bucket) {
+    if (bucket < 2 * LATENCY_SUB_COUNT) return bucket;
+    int shift = bucket / LATENCY_SUB_COUNT - 1;
+    uint64_t sub = bucket % LATENCY_SUB_COUNT + LATENCY_SUB_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+// A copy of a histogram, or the difference of two copies
+struct LatencySnapshot {
+    uint64_t counts[LATENCY_BUCKETS];
+    uint64_t total;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+
+    void subtract(const LatencySnapshot& earlier) {
+        for (int b = 0; b < LATENCY_BUCKETS; b++) counts[b] -= earlier.counts[b];
+        total -= earlier.total;
+        sum_ns -= earlier.sum_ns;
+    }
+
+    // Smallest bucket limit with at least fraction q of the samples at or
+    // below it, capped at the largest sample seen
+    uint64_t percentile(double q) const {
+        if (total == 0) return 0;
+        uint64_t rank = (uint64_t)std::ceil(q * total);
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            seen += counts[b];
+            if (seen >= rank) {
+                uint64_t limit = latencyBucketLimit(b);
+                return limit < max_ns ? limit : max_ns;
+            }
+        }
+        return max_ns;
+    }
+
+    double mean() const { return total ? (double)sum_ns / total : 0; }
+};
+
+class LatencyHistogram {
+
+private:
+    std::atomic<uint64_t> counts[LATENCY_BUCKETS];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum_ns;
+    std::atomic<uint64_t> max_ns;           // since the last snapshot()
+
+public:
+    LatencyHistogram() {
+        for (int b = 0; b < LATENCY_BUCKETS; b++) counts[b].store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        sum_ns.store(0, std::memory_order_relaxed);
+        max_ns.store(0, std::memory_order_relaxed);
+    }
+
+    void record(uint64_t ns) {
+        counts[latencyBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        sum_ns.fetch_add(ns, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t seen = max_ns.load(std::memory_order_relaxed);
+        while (ns > seen &&
+               !max_ns.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Counts since the histogram was made. The maximum is the largest
+    // sample since the previous call, which is reset, so successive
+    // snapshots each carry the maximum of their own interval.
+    void snapshot(LatencySnapshot& out) {
+        out.max_ns = max_ns.exchange(0, std::memory_order_relaxed);
+        out.total = total.load(std::memory_order_relaxed);
+        out.sum_ns = sum_ns.load(std::memory_order_relaxed);
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            out.counts[b] = counts[b].load(std::memory_order_relaxed);
+        }
+    }
+};
+
+#endif /* LATENCY_HISTOGRAM_H_ */
@@ -3,11 +3,15 @@
 
 #include <pthread.h>
 #include <ctime>
+#include <sstream>
+#include <string>
 
-#define MAX_OPERATOR_COMMANDS 100
+// CommandRing from the OperatorConsole (producer) to the ComputerSystem
+// (consumer, owner of the segment)
 #define OPERATOR_COMMAND_SHM_NAME "/operator_commands"
 #define OPERATOR_CONSOLE_CHANNEL_NAME "operator_console"
-#define OPERATOR_VIOLATIONS_CHANNEL_NAME "operator_violations"
+// Leads a command resent by AirspaceManager --replay
+#define REPLAY_COMMAND_PREFIX "REPLAY"
 
 enum CommandType {
     ChangePosition,
@@ -33,13 +37,51 @@ struct OperatorCommand {
     Position position;
     Speed speed;
     time_t timestamp;
+    bool replayed;          // from a recorded session; the recording already
+                            // carries its effect, so it is not delivered
 };
 
-struct OperatorCommandMemory {
-    pthread_mutex_t lock;
-    int command_count;
-    bool updated;
-    OperatorCommand commands[MAX_OPERATOR_COMMANDS];
-};
+// Parses "<type> <aircraft id> [x y z]" as typed at the console. Fields
+// a command does not use are -1. Returns false for an unknown type, which
+// is left in type for the caller to report; "ALERT:" lines are accepted
+// as they are. A leading REPLAY_COMMAND_PREFIX marks the command replayed.
+inline bool parseOperatorCommand(const std::string& raw_cmd, OperatorCommand& cmd,
+                                 std::string& type) {
+    const double UNSET = -1.0;
+
+    std::istringstream ss(raw_cmd);
+    int aircraft_id = 0;
+    double x = UNSET, y = UNSET, z = UNSET;
+
+    bool replayed = false;
+    ss >> type;
+    if (type == REPLAY_COMMAND_PREFIX) {
+        replayed = true;
+        ss >> type;
+    }
+    ss >> aircraft_id >> x >> y >> z;
+
+    cmd = {};
+    cmd.replayed = replayed;
+    cmd.aircraft_id = aircraft_id;
+    cmd.timestamp = time(NULL);
+
+    if (type == "ChangeSpeed") {
+        cmd.type = CommandType::ChangeSpeed;
+        cmd.speed = {x, y, z};
+        cmd.position = {UNSET, UNSET, UNSET};
+    } else if (type == "ChangePosition") {
+        cmd.type = CommandType::ChangePosition;
+        cmd.position = {x, y, z};
+        cmd.speed = {UNSET, UNSET, UNSET};
+    } else if (type == "RequestDetails") {
+        cmd.type = CommandType::RequestDetails;
+        cmd.position = {UNSET, UNSET, UNSET};
+        cmd.speed = {UNSET, UNSET, UNSET};
+    } else if (type != "ALERT:") {
+        return false;
+    }
+    return true;
+}
 
 #endif // OPERATOR_COMMAND_H
@@ -3,13 +3,252 @@
  *
  *  Created on: Mar 17, 2025
  *      Author: david
+ *
+ * Process-shared metrics registry: one named segment of counters, gauges
+ * and fixed-bucket latency histograms that every subsystem writes into and
+ * TracomTop samples live. Whichever process gets there first creates the
+ * segment; the rest map it. A metric is registered once by name (processes
+ * registering the same name share it) and updated through a small handle,
+ * so recording is one to five relaxed atomic adds on the caller's thread
+ * and nothing else.
+ *
+ * Slots are claimed in order and never freed, so registration needs no
+ * lock: a slot's kind is CAS'd to METRIC_CLAIMING, the name written, then
+ * the kind published. A registrant that finds a slot being claimed waits
+ * for it, so two processes registering the same new name end up sharing
+ * one slot. Without a segment, or once it is full, handles write to a
+ * private slot nobody reads, so callers never have to check.
+ *
+ * Histogram bucket 0 holds samples under 1 us and bucket b those in
+ * [2^(b-1), 2^b) us; the last bucket takes everything longer.
  */
 
 #ifndef SRC_PERFORMANCE_METRICS_H_
 #define SRC_PERFORMANCE_METRICS_H_
 
+#include <fcntl.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <atomic>
+
+#define METRICS_SHM_NAME "/tracom_metrics"
+#define METRICS_MAGIC 0x4D455452                // "METR"
+#define METRICS_LAYOUT_VERSION 1
+#define METRICS_MAX 128
+#define METRICS_NAME_SIZE 48
+#define METRICS_BUCKETS 32
+#define METRICS_ATTACH_WAIT_MS 1000
+
+enum MetricKind : uint32_t {
+    METRIC_FREE = 0,
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM,
+    METRIC_CLAIMING
+};
+
+struct MetricSlot {
+    std::atomic<uint32_t> kind;                 // published last
+    char name[METRICS_NAME_SIZE];
+    std::atomic<int64_t> value;                 // counter total, gauge level, histogram samples
+    std::atomic<uint64_t> sum_ns;               // histogram only
+    std::atomic<uint64_t> max_ns;               // histogram only, whole run
+    std::atomic<uint64_t> buckets[METRICS_BUCKETS];
+};
+
+struct MetricsSegment {
+    uint32_t magic;                             // set last, once the slots are ready
+    uint32_t layout_version;
+    int64_t created;                            // time(), so a reader sees a restart
+    MetricSlot metrics[METRICS_MAX];
+};
+
+inline int metricBucket(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int b = 0;
+    while (us != 0 && b < METRICS_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+// Upper bound of a bucket in ns; the last one is open-ended
+inline uint64_t metricBucketLimit(int bucket) {
+    return (uint64_t)1000 << bucket;
+}
+
+inline const char* metricKindName(uint32_t kind) {
+    switch (kind) {
+    case METRIC_COUNTER:   return "counter";
+    case METRIC_GAUGE:     return "gauge";
+    case METRIC_HISTOGRAM: return "histogram";
+    default:               return "?";
+    }
+}
+
+class MetricCounter {
+    MetricSlot* slot;
+public:
+    explicit MetricCounter(MetricSlot* slot) : slot(slot) {}
+    void add(int64_t n = 1) { slot->value.fetch_add(n, std::memory_order_relaxed); }
+};
+
+class MetricGauge {
+    MetricSlot* slot;
+public:
+    explicit MetricGauge(MetricSlot* slot) : slot(slot) {}
+    void set(int64_t v) { slot->value.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { slot->value.fetch_add(n, std::memory_order_relaxed); }
+};
+
+class MetricHistogram {
+    MetricSlot* slot;
+public:
+    explicit MetricHistogram(MetricSlot* slot) : slot(slot) {}
+
+    void record(uint64_t ns) {
+        slot->buckets[metricBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        slot->sum_ns.fetch_add(ns, std::memory_order_relaxed);
+        slot->value.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t seen = slot->max_ns.load(std::memory_order_relaxed);
+        while (ns > seen &&
+               !slot->max_ns.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    void record(const timespec& start, const timespec& end) {
+        int64_t ns = (int64_t)(end.tv_sec - start.tv_sec) * 1000000000LL +
+                     (end.tv_nsec - start.tv_nsec);
+        record(ns < 0 ? 0 : (uint64_t)ns);
+    }
+};
+
+// Owner side, on freshly zeroed memory
+inline void initMetricsSegment(MetricsSegment* segment) {
+    segment->layout_version = METRICS_LAYOUT_VERSION;
+    segment->created = time(NULL);
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->magic = METRICS_MAGIC;
+}
+
+inline bool metricsSegmentReady(const MetricsSegment* segment) {
+    if (segment->magic != METRICS_MAGIC || segment->layout_version != METRICS_LAYOUT_VERSION) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+class MetricsRegistry {
+
+private:
+    MetricsSegment* segment = nullptr;
+    MetricSlot unlisted{};                      // where handles write without a segment
+
+    static void pause() {
+        timespec ms = {0, 1000000};
+        nanosleep(&ms, NULL);
+    }
+
+    // Creates the segment, or maps the one another process created
+    void attach() {
+        bool created = true;
+        int fd = shm_open(METRICS_SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0666);
+        if (fd == -1) {
+            created = false;
+            fd = shm_open(METRICS_SHM_NAME, O_RDWR, 0666);
+        } else if (ftruncate(fd, sizeof(MetricsSegment)) == -1) {
+            perror("[Metrics] ftruncate failed");
+            close(fd);
+            shm_unlink(METRICS_SHM_NAME);
+            return;
+        }
+        if (fd == -1) {
+            perror("[Metrics] shm_open failed");
+            return;
+        }
+
+        // The creator may not have sized or initialised it yet
+        struct stat st;
+        int waited = 0;
+        while (!created && (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(MetricsSegment))) {
+            if (++waited > METRICS_ATTACH_WAIT_MS) break;
+            pause();
+        }
+
+        void* addr = mmap(NULL, sizeof(MetricsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            perror("[Metrics] mmap failed");
+            return;
+        }
+        MetricsSegment* s = static_cast<MetricsSegment*>(addr);
+        if (created) initMetricsSegment(s);
+
+        while (!metricsSegmentReady(s) && waited++ <= METRICS_ATTACH_WAIT_MS) pause();
+        if (!metricsSegmentReady(s)) {
+            fprintf(stderr, "[Metrics] %s has another layout; metrics are not shared\n",
+                    METRICS_SHM_NAME);
+            munmap(addr, sizeof(MetricsSegment));
+            return;
+        }
+        segment = s;
+    }
+
+    MetricSlot* find(const char* name, MetricKind kind) {
+        if (segment == nullptr) return &unlisted;
+
+        for (MetricSlot& slot : segment->metrics) {
+            uint32_t k = slot.kind.load(std::memory_order_acquire);
+            if (k == METRIC_FREE) {
+                if (slot.kind.compare_exchange_strong(k, METRIC_CLAIMING, std::memory_order_acquire)) {
+                    strncpy(slot.name, name, METRICS_NAME_SIZE - 1);
+                    slot.name[METRICS_NAME_SIZE - 1] = '\0';
+                    slot.kind.store(kind, std::memory_order_release);
+                    return &slot;
+                }
+            }
+            // Another process is naming this slot; it may be ours
+            for (int waited = 0; k == METRIC_CLAIMING && waited < METRICS_ATTACH_WAIT_MS; waited++) {
+                pause();
+                k = slot.kind.load(std::memory_order_acquire);
+            }
+            if (k == (uint32_t)kind && strncmp(slot.name, name, METRICS_NAME_SIZE - 1) == 0) {
+                return &slot;
+            }
+        }
+        fprintf(stderr, "[Metrics] No room for %s, not shared\n", name);
+        return &unlisted;
+    }
+
+public:
+    MetricsRegistry() { attach(); }
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    // Left mapped: handles in static objects may still be written to
+    // while the process exits
 
+    MetricCounter counter(const char* name) { return MetricCounter(find(name, METRIC_COUNTER)); }
+    MetricGauge gauge(const char* name) { return MetricGauge(find(name, METRIC_GAUGE)); }
+    MetricHistogram histogram(const char* name) { return MetricHistogram(find(name, METRIC_HISTOGRAM)); }
 
+    bool shared() const { return segment != nullptr; }
+};
 
+// The process's registry, attached on first use
+inline MetricsRegistry& metrics() {
+    static MetricsRegistry registry;
+    return registry;
+}
 
 #endif /* SRC_PERFORMANCE_METRICS_H_ */
@@ -0,0 +1,20 @@
+/*
+ * radar_coverage.h
+ *
+ * Volume the primary radar sees: the 100 km x 100 km sector between
+ * 15000 m and 25000 m.
+ */
+
+#ifndef RADAR_COVERAGE_H_
+#define RADAR_COVERAGE_H_
+
+#define RADAR_RANGE_XY 100000.0
+#define RADAR_FLOOR 15000.0
+#define RADAR_CEILING 25000.0
+
+inline bool inRadarCoverage(double x, double y, double z) {
+    return !(x > RADAR_RANGE_XY || y > RADAR_RANGE_XY ||
+             x < 0 || y < 0 || z > RADAR_CEILING || z < RADAR_FLOOR);
+}
+
+#endif /* RADAR_COVERAGE_H_ */
@@ -0,0 +1,461 @@
+/*
+ * scenario_loader.h
+ *
+ * Loads a traffic scenario file, one aircraft per line:
+ *
+ *   <entry time> <id> <x> <y> <z> <speedX> <speedY> <speedZ>
+ *
+ * The entry time is an epoch timestamp (9 or more digits), a date
+ * "YYYY-MM-DD" optionally followed by a time "HH:MM:SS", a time "HH:MM:SS"
+ * today, or a relative offset in seconds (fewer than 9 digits). Blank
+ * lines and lines starting with '#' are skipped. A malformed line is
+ * reported with its line number and left out; the rest still load.
+ *
+ * The file is memory-mapped and parsed in place: no per-line strings or
+ * streams, no regex, no locale. Numbers go through a hand-written decimal
+ * parser that is exact for the plain decimals scenarios hold and falls
+ * back to strtod for anything longer. Local times only call mktime() when
+ * the hour changes, since DST can only move on hour boundaries. Large
+ * files can be split into line-aligned chunks parsed on separate threads;
+ * the result is the same, in file order.
+ *
+ * The same call also loads the binary form written by the
+ * ScenarioGenerator: a ScenarioFileHeader followed by fixed-size records.
+ * For a binary file, error "lines" are record numbers.
+ */
+
+#ifndef SCENARIO_LOADER_H_
+#define SCENARIO_LOADER_H_
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#include "aircraft_data.h"
+
+#define MAX_SCENARIO_THREADS 64
+
+#define SCENARIO_BINARY_MAGIC 0x4E435342    // "BSCN"
+#define SCENARIO_BINARY_VERSION 1
+
+// Binary scenario: ScenarioFileHeader | ScenarioRecord[count]. Positions
+// are in cm and speeds in cm/s, which converts back to exactly the value
+// the two-decimal text form gives.
+struct ScenarioFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+    int64_t base_time;          // epoch of entry offset 0; 0 means load time
+};
+
+struct ScenarioRecord {
+    uint32_t entry_offset;      // seconds after base_time
+    int32_t id;
+    int32_t position_cm[3];
+    int32_t speed_cm[3];
+};
+
+struct ScenarioError {
+    size_t line;                // 1-based
+    std::string message;
+};
+
+struct Scenario {
+    std::vector<std::pair<time_t, AircraftData>> aircraft;     // in file order
+    std::vector<ScenarioError> errors;
+    size_t bytes = 0;
+    size_t lines = 0;
+};
+
+// mktime() once per local hour; minutes and seconds are added on top.
+// A few hours are kept, since a file can mix dates with times of today.
+struct LocalTimeCache {
+    struct Entry {
+        int key = -1;
+        time_t base = 0;
+    };
+    Entry entries[16];
+
+    time_t at(int y, int mo, int d, int h, int mi, int s) {
+        int key = ((y * 12 + mo) * 31 + d) * 24 + h;
+        Entry& e = entries[(key ^ (key >> 4)) & 15];
+        if (e.key != key) {
+            tm t = {};
+            t.tm_year = y - 1900;
+            t.tm_mon = mo - 1;
+            t.tm_mday = d;
+            t.tm_hour = h;
+            t.tm_isdst = -1;
+            e.base = mktime(&t);
+            e.key = key;
+        }
+        return e.base + mi * 60 + s;
+    }
+};
+
+inline bool isScenarioSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Reads exactly n digits at p
+inline bool scanFixedDigits(const char* p, int n, int& out) {
+    int v = 0;
+    for (int i = 0; i < n; i++) {
+        unsigned d = (unsigned char)p[i] - '0';
+        if (d > 9) return false;
+        v = v * 10 + d;
+    }
+    out = v;
+    return true;
+}
+
+// Whole token [p, end) as a signed integer
+inline bool scanInteger(const char* p, const char* end, long long& out) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    if (p == end || end - p > 18) return false;
+
+    long long v = 0;
+    for (; p < end; p++) {
+        unsigned d = (unsigned char)*p - '0';
+        if (d > 9) return false;
+        v = v * 10 + d;
+    }
+    out = negative ? -v : v;
+    return true;
+}
+
+// Whole token [p, end) as a double. Up to 19 significant digits scaled by
+// at most 10^22 is a single correctly rounded operation (Clinger's fast
+// path); longer mantissas and exponents go through strtod.
+inline bool scanDouble(const char* p, const char* end, double& out) {
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* token = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    uint64_t mantissa = 0;
+    int significant = 0, scale = 0, digits = 0;
+    for (; p < end && (unsigned)(*p - '0') <= 9; p++, digits++) {
+        if (mantissa != 0 || *p != '0') significant++;
+        mantissa = mantissa * 10 + (*p - '0');
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && (unsigned)(*p - '0') <= 9; p++, digits++) {
+            if (mantissa != 0 || *p != '0') significant++;
+            mantissa = mantissa * 10 + (*p - '0');
+            scale--;
+        }
+    }
+    if (digits == 0) return false;
+
+    if (p == end && significant <= 19 && mantissa <= (1ull << 53) && scale >= -22) {
+        double v = (double)mantissa / pow10[-scale];
+        out = negative ? -v : v;
+        return true;
+    }
+
+    // Exponents, or more digits than the fast path handles exactly
+    char buffer[64];
+    size_t length = end - token;
+    if (length >= sizeof(buffer)) return false;
+    memcpy(buffer, token, length);
+    buffer[length] = '\0';
+    char* rest;
+    out = strtod(buffer, &rest);
+    return rest == buffer + length;
+}
+
+// "HH:MM:SS"
+inline bool scanClock(const char* p, const char* end, int& h, int& mi, int& s) {
+    return end - p == 8 && p[2] == ':' && p[5] == ':' &&
+           scanFixedDigits(p, 2, h) && scanFixedDigits(p + 3, 2, mi) &&
+           scanFixedDigits(p + 6, 2, s) && h < 24 && mi < 60 && s <= 60;
+}
+
+// "YYYY-MM-DD"
+inline bool scanDate(const char* p, const char* end, int& y, int& mo, int& d) {
+    return end - p == 10 && p[4] == '-' && p[7] == '-' &&
+           scanFixedDigits(p, 4, y) && scanFixedDigits(p + 5, 2, mo) &&
+           scanFixedDigits(p + 8, 2, d) && mo >= 1 && mo <= 12 && d >= 1 && d <= 31;
+}
+
+// Entry time from a single token; a date token yields midnight and
+// reports itself through is_date, so the caller can look for a time next.
+// today is now's local date.
+inline bool scanEntryTime(const char* p, const char* end, time_t now, const tm& today,
+                          LocalTimeCache& cache, time_t& out, bool* is_date = nullptr) {
+    if (is_date) *is_date = false;
+    long long n;
+    if (end - p < 19 && (unsigned)(*p - '0') <= 9 && scanInteger(p, end, n)) {
+        out = end - p >= 9 ? (time_t)n : now + n;
+        return true;
+    }
+
+    int y, mo, d, h, mi, s;
+    if (scanDate(p, end, y, mo, d)) {
+        out = cache.at(y, mo, d, 0, 0, 0);
+        if (is_date) *is_date = true;
+        return out != -1;
+    }
+    if (scanClock(p, end, h, mi, s)) {
+        out = cache.at(today.tm_year + 1900, today.tm_mon + 1, today.tm_mday, h, mi, s);
+        return out != -1;
+    }
+    return false;
+}
+
+// One entry time in any of the formats above, -1 if it is none of them
+inline time_t parseToTimeT(const std::string& input) {
+    thread_local LocalTimeCache cache;
+    time_t now = time(NULL);
+    tm today;
+    localtime_r(&now, &today);
+
+    time_t when;
+    const char* p = input.c_str();
+    if (input.empty() || !scanEntryTime(p, p + input.size(), now, today, cache, when)) {
+        return -1;
+    }
+    return when;
+}
+
+struct ScenarioChunk {
+    const char* begin;
+    const char* end;
+    time_t now;
+    size_t lines = 0;
+    std::vector<std::pair<time_t, AircraftData>> aircraft;
+    std::vector<ScenarioError> errors;      // line numbers relative to the chunk
+};
+
+inline void parseScenarioChunk(ScenarioChunk& chunk) {
+    LocalTimeCache cache;
+    tm today;
+    localtime_r(&chunk.now, &today);
+    chunk.aircraft.reserve((chunk.end - chunk.begin) / 48);
+
+    static const char* const field_names[] = {
+        "entry time", "id", "x", "y", "z", "speedX", "speedY", "speedZ"
+    };
+
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', chunk.end - p));
+        if (eol == nullptr) eol = chunk.end;
+        size_t line = ++chunk.lines;
+
+        // Up to 9 fields with a two-token time; a tenth token is garbage
+        const char* start[10];
+        const char* stop[10];
+        int count = 0;
+        const char* q = p;
+        while (count < 10) {
+            while (q < eol && isScenarioSpace(*q)) q++;
+            if (q == eol) break;
+            start[count] = q;
+            while (q < eol && !isScenarioSpace(*q)) q++;
+            stop[count++] = q;
+        }
+        p = eol + 1;
+
+        if (count == 0 || *start[0] == '#') continue;
+
+        std::string error;
+        AircraftData a = {};
+        bool is_date;
+        int field = 1;
+        if (!scanEntryTime(start[0], stop[0], chunk.now, today, cache, a.entryTime, &is_date)) {
+            error = "invalid entry time '" + std::string(start[0], stop[0]) + "'";
+        }
+
+        // "YYYY-MM-DD HH:MM:SS" spans two tokens
+        int h, mi, s;
+        if (error.empty() && is_date && count > 1 && scanClock(start[1], stop[1], h, mi, s)) {
+            int y = 0, mo = 0, d = 0;
+            scanDate(start[0], stop[0], y, mo, d);
+            a.entryTime = cache.at(y, mo, d, h, mi, s);
+            field = 2;
+        }
+
+        long long id = 0;
+        double* values[] = {&a.x, &a.y, &a.z, &a.speedX, &a.speedY, &a.speedZ};
+        if (error.empty() && count - field < 7) {
+            error = "expected 8 fields, found " + std::to_string(count - field + 1);
+        } else if (error.empty() && count - field > 7) {
+            error = "unexpected text after speedZ";
+        } else if (error.empty() && (!scanInteger(start[field], stop[field], id) ||
+                                     id <= 0 || id > 0x7fffffff)) {
+            error = "invalid id '" + std::string(start[field], stop[field]) + "'";
+        }
+        for (int k = 0; error.empty() && k < 6; k++) {
+            int f = field + 1 + k;
+            if (!scanDouble(start[f], stop[f], *values[k])) {
+                error = std::string("invalid ") + field_names[k + 2] + " '" +
+                        std::string(start[f], stop[f]) + "'";
+            }
+        }
+
+        if (!error.empty()) {
+            chunk.errors.push_back({line, error});
+            continue;
+        }
+        a.id = (int)id;
+        chunk.aircraft.emplace_back(a.entryTime, a);
+    }
+}
+
+inline void* scenarioChunkThread(void* arg) {
+    parseScenarioChunk(*static_cast<ScenarioChunk*>(arg));
+    return nullptr;
+}
+
+// Parses a scenario held in memory, on up to `threads` threads
+inline void parseScenario(const char* data, size_t size, Scenario& out,
+                          int threads = 1, time_t now = time(NULL)) {
+    threads = std::max(1, std::min(threads, MAX_SCENARIO_THREADS));
+    // Chunks below 1 MB are not worth a thread
+    threads = std::max(1, std::min<int>(threads, size >> 20));
+
+    std::vector<ScenarioChunk> chunks;
+    const char* begin = data;
+    const char* end = data + size;
+    for (int t = 0; t < threads && begin < end; t++) {
+        const char* split = t == threads - 1 ? end : data + size / threads * (t + 1);
+        if (split < begin) split = begin;
+        if (split < end) {
+            const char* eol = static_cast<const char*>(memchr(split, '\n', end - split));
+            split = eol ? eol + 1 : end;
+        }
+        chunks.push_back({begin, split, now});
+        begin = split;
+    }
+
+    std::vector<pthread_t> workers(chunks.size());
+    for (size_t c = 1; c < chunks.size(); c++) {
+        pthread_create(&workers[c], NULL, scenarioChunkThread, &chunks[c]);
+    }
+    if (!chunks.empty()) parseScenarioChunk(chunks[0]);
+    for (size_t c = 1; c < chunks.size(); c++) pthread_join(workers[c], NULL);
+
+    size_t total = out.aircraft.size();
+    for (ScenarioChunk& chunk : chunks) total += chunk.aircraft.size();
+    out.aircraft.reserve(total);
+
+    size_t line_base = out.lines;
+    for (ScenarioChunk& chunk : chunks) {
+        out.aircraft.insert(out.aircraft.end(), chunk.aircraft.begin(), chunk.aircraft.end());
+        for (ScenarioError& e : chunk.errors) {
+            out.errors.push_back({line_base + e.line, std::move(e.message)});
+        }
+        line_base += chunk.lines;
+    }
+    out.lines = line_base;
+    out.bytes += size;
+}
+
+// Decodes a binary scenario held in memory
+inline void parseScenarioBinary(const char* data, size_t size, Scenario& out,
+                                time_t now = time(NULL)) {
+    ScenarioFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.version != SCENARIO_BINARY_VERSION) {
+        out.errors.push_back({0, "unsupported binary scenario version " +
+                                 std::to_string(header.version)});
+        return;
+    }
+
+    uint64_t fits = (size - sizeof(header)) / sizeof(ScenarioRecord);
+    uint64_t count = std::min(header.count, fits);
+    if (count < header.count) {
+        out.errors.push_back({count + 1, "file truncated, " + std::to_string(header.count) +
+                                         " records announced"});
+    }
+
+    time_t base = header.base_time != 0 ? (time_t)header.base_time : now;
+    const ScenarioRecord* records = reinterpret_cast<const ScenarioRecord*>(data + sizeof(header));
+    out.aircraft.reserve(out.aircraft.size() + count);
+    for (uint64_t k = 0; k < count; k++) {
+        ScenarioRecord r;
+        memcpy(&r, &records[k], sizeof(r));
+        if (r.id <= 0) {
+            out.errors.push_back({k + 1, "invalid id " + std::to_string(r.id)});
+            continue;
+        }
+
+        AircraftData a = {};
+        a.entryTime = base + r.entry_offset;
+        a.id = r.id;
+        a.x = r.position_cm[0] / 100.0;
+        a.y = r.position_cm[1] / 100.0;
+        a.z = r.position_cm[2] / 100.0;
+        a.speedX = r.speed_cm[0] / 100.0;
+        a.speedY = r.speed_cm[1] / 100.0;
+        a.speedZ = r.speed_cm[2] / 100.0;
+        out.aircraft.emplace_back(a.entryTime, a);
+    }
+    out.lines += count;
+    out.bytes += size;
+}
+
+inline bool isBinaryScenario(const char* data, size_t size) {
+    uint32_t magic;
+    if (size < sizeof(ScenarioFileHeader)) return false;
+    memcpy(&magic, data, sizeof(magic));
+    return magic == SCENARIO_BINARY_MAGIC;
+}
+
+// Maps the file read-only and parses it in place. Returns false if the
+// file cannot be read; malformed lines only show up in out.errors.
+inline bool loadScenarioFile(const char* path, Scenario& out,
+                             int threads = 1, time_t now = time(NULL)) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        perror("[ScenarioLoader] open failed");
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        perror("[ScenarioLoader] fstat failed");
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        perror("[ScenarioLoader] mmap failed");
+        return false;
+    }
+    posix_madvise(addr, st.st_size, POSIX_MADV_SEQUENTIAL);
+
+    const char* data = static_cast<const char*>(addr);
+    if (isBinaryScenario(data, st.st_size)) {
+        parseScenarioBinary(data, st.st_size, out, now);
+    } else {
+        parseScenario(data, st.st_size, out, threads, now);
+    }
+    munmap(addr, st.st_size);
+    return true;
+}
+
+#endif /* SCENARIO_LOADER_H_ */
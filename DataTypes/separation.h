@@ -0,0 +1,21 @@
+/*
+ * separation.h
+ *
+ * Separation minima shared by the conflict checkers.
+ */
+
+#ifndef SEPARATION_H_
+#define SEPARATION_H_
+
+#include <cmath>
+
+#define HORIZONTAL_SEPARATION 3000.0
+#define VERTICAL_SEPARATION   1000.0
+
+// Separation is lost only when both minima are breached at the same time.
+inline bool isLossOfSeparation(double dx, double dy, double dz) {
+    return std::fabs(dz) < VERTICAL_SEPARATION &&
+           dx * dx + dy * dy < HORIZONTAL_SEPARATION * HORIZONTAL_SEPARATION;
+}
+
+#endif /* SEPARATION_H_ */
@@ -0,0 +1,222 @@
+/*
+ * separation_simd.h
+ *
+ * One-against-many separation kernels over structure-of-arrays positions.
+ * The ISA is picked at compile time: AVX2 tests 4 aircraft per instruction
+ * (build with -mavx2), SSE2 tests 2 and is the x86_64 baseline, anything
+ * else uses the scalar path. Every kernel finishes its tail with the scalar
+ * path, so counts need no padding.
+ */
+
+#ifndef SEPARATION_SIMD_H_
+#define SEPARATION_SIMD_H_
+
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+#include "airspace.h"
+#include "separation.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace simd {
+
+struct ScalarD {
+    static const int LANES = 1;
+    struct Mask { bool m; };
+    double v;
+
+    static ScalarD load(const double* p) { return {*p}; }
+    static ScalarD set1(double d) { return {d}; }
+    static int bits(Mask m) { return m.m; }
+    static const char* name() { return "scalar"; }
+
+    friend ScalarD operator+(ScalarD a, ScalarD b) { return {a.v + b.v}; }
+    friend ScalarD operator-(ScalarD a, ScalarD b) { return {a.v - b.v}; }
+    friend ScalarD operator*(ScalarD a, ScalarD b) { return {a.v * b.v}; }
+    friend ScalarD operator/(ScalarD a, ScalarD b) { return {a.v / b.v}; }
+    friend ScalarD min(ScalarD a, ScalarD b) { return {a.v < b.v ? a.v : b.v}; }
+    friend ScalarD max(ScalarD a, ScalarD b) { return {a.v > b.v ? a.v : b.v}; }
+    friend ScalarD sqrt(ScalarD a) { return {std::sqrt(a.v)}; }
+    friend ScalarD abs(ScalarD a) { return {std::fabs(a.v)}; }
+    friend Mask operator<(ScalarD a, ScalarD b) { return {a.v < b.v}; }
+    friend Mask operator==(ScalarD a, ScalarD b) { return {a.v == b.v}; }
+    friend Mask operator&(Mask a, Mask b) { return {a.m && b.m}; }
+    friend ScalarD select(Mask m, ScalarD a, ScalarD b) { return m.m ? a : b; }
+    void store(double* p) const { *p = v; }
+};
+
+#if defined(__AVX2__)
+struct NativeD {
+    static const int LANES = 4;
+    struct Mask { __m256d m; };
+    __m256d v;
+
+    static NativeD load(const double* p) { return {_mm256_loadu_pd(p)}; }
+    static NativeD set1(double d) { return {_mm256_set1_pd(d)}; }
+    static int bits(Mask m) { return _mm256_movemask_pd(m.m); }
+    static const char* name() { return "avx2"; }
+
+    friend NativeD operator+(NativeD a, NativeD b) { return {_mm256_add_pd(a.v, b.v)}; }
+    friend NativeD operator-(NativeD a, NativeD b) { return {_mm256_sub_pd(a.v, b.v)}; }
+    friend NativeD operator*(NativeD a, NativeD b) { return {_mm256_mul_pd(a.v, b.v)}; }
+    friend NativeD operator/(NativeD a, NativeD b) { return {_mm256_div_pd(a.v, b.v)}; }
+    friend NativeD min(NativeD a, NativeD b) { return {_mm256_min_pd(a.v, b.v)}; }
+    friend NativeD max(NativeD a, NativeD b) { return {_mm256_max_pd(a.v, b.v)}; }
+    friend NativeD sqrt(NativeD a) { return {_mm256_sqrt_pd(a.v)}; }
+    friend NativeD abs(NativeD a) { return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)}; }
+    friend Mask operator<(NativeD a, NativeD b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)}; }
+    friend Mask operator==(NativeD a, NativeD b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ)}; }
+    friend Mask operator&(Mask a, Mask b) { return {_mm256_and_pd(a.m, b.m)}; }
+    friend NativeD select(Mask m, NativeD a, NativeD b) { return {_mm256_blendv_pd(b.v, a.v, m.m)}; }
+    void store(double* p) const { _mm256_storeu_pd(p, v); }
+};
+#elif defined(__SSE2__)
+struct NativeD {
+    static const int LANES = 2;
+    struct Mask { __m128d m; };
+    __m128d v;
+
+    static NativeD load(const double* p) { return {_mm_loadu_pd(p)}; }
+    static NativeD set1(double d) { return {_mm_set1_pd(d)}; }
+    static int bits(Mask m) { return _mm_movemask_pd(m.m); }
+    static const char* name() { return "sse2"; }
+
+    friend NativeD operator+(NativeD a, NativeD b) { return {_mm_add_pd(a.v, b.v)}; }
+    friend NativeD operator-(NativeD a, NativeD b) { return {_mm_sub_pd(a.v, b.v)}; }
+    friend NativeD operator*(NativeD a, NativeD b) { return {_mm_mul_pd(a.v, b.v)}; }
+    friend NativeD operator/(NativeD a, NativeD b) { return {_mm_div_pd(a.v, b.v)}; }
+    friend NativeD min(NativeD a, NativeD b) { return {_mm_min_pd(a.v, b.v)}; }
+    friend NativeD max(NativeD a, NativeD b) { return {_mm_max_pd(a.v, b.v)}; }
+    friend NativeD sqrt(NativeD a) { return {_mm_sqrt_pd(a.v)}; }
+    friend NativeD abs(NativeD a) { return {_mm_andnot_pd(_mm_set1_pd(-0.0), a.v)}; }
+    friend Mask operator<(NativeD a, NativeD b) { return {_mm_cmplt_pd(a.v, b.v)}; }
+    friend Mask operator==(NativeD a, NativeD b) { return {_mm_cmpeq_pd(a.v, b.v)}; }
+    friend Mask operator&(Mask a, Mask b) { return {_mm_and_pd(a.m, b.m)}; }
+    friend NativeD select(Mask m, NativeD a, NativeD b) {
+        return {_mm_or_pd(_mm_and_pd(m.m, a.v), _mm_andnot_pd(m.m, b.v))};
+    }
+    void store(double* p) const { _mm_storeu_pd(p, v); }
+};
+#else
+typedef ScalarD NativeD;
+#endif
+
+// Current loss of separation between aircraft i and j in [begin, end)
+template <typename V>
+int separationBlock(const SoAView& s, int i, int& j, int end, int* hits) {
+    const V xi = V::set1(s.x[i]), yi = V::set1(s.y[i]), zi = V::set1(s.z[i]);
+    const V h2 = V::set1(HORIZONTAL_SEPARATION * HORIZONTAL_SEPARATION);
+    const V vsep = V::set1(VERTICAL_SEPARATION);
+    int found = 0;
+
+    for (; j + V::LANES <= end; j += V::LANES) {
+        V dx = V::load(s.x + j) - xi;
+        V dy = V::load(s.y + j) - yi;
+        V dz = abs(V::load(s.z + j) - zi);
+        int bits = V::bits((dx * dx + dy * dy < h2) & (dz < vsep));
+
+        while (bits) {
+            int lane = __builtin_ctz(bits);
+            bits &= bits - 1;
+            if (s.active[j + lane]) hits[found++] = j + lane;
+        }
+    }
+    return found;
+}
+
+// Time until both minima are breached for i against the lanes at j, or a
+// negative value when separation holds for the whole window. Same algebra
+// as predictConflict(), with the branches turned into selects.
+template <typename V>
+V timeToLoss(const SoAView& s, const V (&pi)[6], int j, V lookahead) {
+    const V zero = V::set1(0.0);
+    const V inf = V::set1(std::numeric_limits<double>::infinity());
+    const V h2 = V::set1(HORIZONTAL_SEPARATION * HORIZONTAL_SEPARATION);
+    const V vsep = V::set1(VERTICAL_SEPARATION);
+
+    V px = pi[0] - V::load(s.x + j), py = pi[1] - V::load(s.y + j), pz = pi[2] - V::load(s.z + j);
+    V vx = pi[3] - V::load(s.vx + j), vy = pi[4] - V::load(s.vy + j), vz = pi[5] - V::load(s.vz + j);
+
+    // Horizontal: |p + v t|^2 < H^2
+    V vv = vx * vx + vy * vy;
+    V pv = px * vx + py * vy;
+    V c = px * px + py * py - h2;
+    V disc = pv * pv - vv * c;
+    V root = sqrt(max(disc, zero));
+    V h_lo = (zero - pv - root) / vv;
+    V h_hi = (zero - pv + root) / vv;
+    h_hi = select(zero < disc, h_hi, zero - inf);
+    typename V::Mask still = vv == zero;
+    h_lo = select(still, zero - inf, h_lo);
+    h_hi = select(still, select(c < zero, inf, zero - inf), h_hi);
+
+    // Vertical: |pz + vz t| < V
+    V t1 = (zero - vsep - pz) / vz;
+    V t2 = (vsep - pz) / vz;
+    V v_lo = min(t1, t2), v_hi = max(t1, t2);
+    typename V::Mask level = vz == zero;
+    v_lo = select(level, zero - inf, v_lo);
+    v_hi = select(level, select(abs(pz) < vsep, inf, zero - inf), v_hi);
+
+    V lo = max(max(h_lo, v_lo), zero);
+    V hi = min(min(h_hi, v_hi), lookahead);
+    return select(lo < hi, lo, zero - V::set1(1.0));
+}
+
+template <typename V>
+int conflictBlock(const SoAView& s, int i, int& j, int end, double lookahead,
+                  int* hits, double* times) {
+    const V pi[6] = {V::set1(s.x[i]), V::set1(s.y[i]), V::set1(s.z[i]),
+                     V::set1(s.vx[i]), V::set1(s.vy[i]), V::set1(s.vz[i])};
+    const V window = V::set1(lookahead);
+    const V zero = V::set1(0.0);
+    int found = 0;
+    double lane_times[V::LANES];
+
+    for (; j + V::LANES <= end; j += V::LANES) {
+        V t = timeToLoss<V>(s, pi, j, window);
+        int bits = V::bits(zero < t);
+        if (!bits) continue;
+
+        t.store(lane_times);
+        while (bits) {
+            int lane = __builtin_ctz(bits);
+            bits &= bits - 1;
+            if (s.active[j + lane]) {
+                hits[found] = j + lane;
+                times[found++] = lane_times[lane];
+            }
+        }
+    }
+    return found;
+}
+
+} // namespace simd
+
+inline const char* simdKernelName() { return simd::NativeD::name(); }
+
+// Writes the index of every active j in [begin, end) that has lost
+// separation with i into hits and returns how many were found.
+inline int separationRow(const SoAView& s, int i, int begin, int end, int* hits) {
+    int j = begin;
+    int found = simd::separationBlock<simd::NativeD>(s, i, j, end, hits);
+    return found + simd::separationBlock<simd::ScalarD>(s, i, j, end, hits + found);
+}
+
+// Projects i and every active j in [begin, end) along their velocities and
+// reports the pairs that lose separation later within the window, with the
+// seconds until they do. Pairs already in conflict are left to separationRow.
+inline int conflictRow(const SoAView& s, int i, int begin, int end, double lookahead,
+                       int* hits, double* times) {
+    int j = begin;
+    int found = simd::conflictBlock<simd::NativeD>(s, i, j, end, lookahead, hits, times);
+    return found + simd::conflictBlock<simd::ScalarD>(s, i, j, end, lookahead,
+                                                       hits + found, times + found);
+}
+
+#endif /* SEPARATION_SIMD_H_ */
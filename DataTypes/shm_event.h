@@ -0,0 +1,97 @@
+/*
+ * shm_event.h
+ *
+ * Event counter for waking a thread in another process, placed in shared
+ * memory next to the data it announces. A signal bumps the count; a
+ * waiter remembers the count it last acted on and blocks until it moves,
+ * so a signal sent between checking the data and going to sleep is never
+ * lost.
+ *
+ * The process-shared mutex and condition variable are only touched when
+ * somebody is actually asleep: the signaller bumps the count, then looks
+ * at the waiter count, and a waiter registers itself before re-checking
+ * the count, so one of the two always sees the other.
+ */
+
+#ifndef SHM_EVENT_H_
+#define SHM_EVENT_H_
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+
+struct ShmEvent {
+    std::atomic<uint64_t> count;
+    std::atomic<uint32_t> waiters;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+// Owner side, once, before the segment is published
+inline void initShmEvent(ShmEvent* event) {
+    event->count.store(0);
+    event->waiters.store(0);
+
+    pthread_mutexattr_t mattr;
+    pthread_mutexattr_init(&mattr);
+    pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&event->lock, &mattr);
+    pthread_mutexattr_destroy(&mattr);
+
+    pthread_condattr_t cattr;
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&event->cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+}
+
+inline uint64_t shmEventValue(ShmEvent* event) {
+    return event->count.load(std::memory_order_seq_cst);
+}
+
+// Cheap when nobody waits: one atomic add and one load
+inline void signalShmEvent(ShmEvent* event) {
+    event->count.fetch_add(1, std::memory_order_seq_cst);
+    if (event->waiters.load(std::memory_order_seq_cst) == 0) return;
+
+    pthread_mutex_lock(&event->lock);
+    pthread_cond_broadcast(&event->cond);
+    pthread_mutex_unlock(&event->lock);
+}
+
+// Blocks until the count differs from seen, or timeout_ms passes (a
+// negative timeout waits forever). Returns the current count; the caller
+// compares it with seen to tell a signal from a timeout.
+inline uint64_t waitShmEvent(ShmEvent* event, uint64_t seen, long timeout_ms = -1) {
+    uint64_t now = event->count.load(std::memory_order_seq_cst);
+    if (now != seen) return now;
+
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&event->lock);
+    event->waiters.fetch_add(1, std::memory_order_seq_cst);
+    while ((now = event->count.load(std::memory_order_seq_cst)) == seen) {
+        int rc = timeout_ms >= 0
+            ? pthread_cond_timedwait(&event->cond, &event->lock, &deadline)
+            : pthread_cond_wait(&event->cond, &event->lock);
+        if (rc == ETIMEDOUT) break;
+    }
+    event->waiters.fetch_sub(1, std::memory_order_seq_cst);
+    pthread_mutex_unlock(&event->lock);
+
+    return event->count.load(std::memory_order_seq_cst);
+}
+
+#endif /* SHM_EVENT_H_ */
@@ -0,0 +1,180 @@
+/*
+ * simulation_engine.h
+ *
+ * Advances every registered aircraft slot once per tick from a single
+ * thread (optionally helped by a small fixed worker pool), inside one
+ * airspace write section. Replaces the per-aircraft position threads, which
+ * each woke up and took the airspace lock once a second.
+ */
+
+#ifndef SIMULATION_ENGINE_H_
+#define SIMULATION_ENGINE_H_
+
+#include <pthread.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "airspace.h"
+
+#define SIMULATION_TICK_SEC 1.0
+
+class SimulationEngine {
+
+private:
+    AirspaceMapping* airspace;
+    int workers;
+    double period;
+
+    pthread_mutex_t slots_lock = PTHREAD_MUTEX_INITIALIZER;
+    std::vector<int> slots;     // registered slots, guarded by slots_lock
+    std::vector<int> batch;     // this tick's copy, read by the workers
+
+    pthread_t tick_thread = 0;
+    std::vector<pthread_t> pool;
+    pthread_barrier_t start_barrier, done_barrier;
+    std::atomic<bool> running{false};
+
+    // Current job, published to the pool by the start barrier
+    const AirspaceView* job_view = nullptr;
+    time_t job_now = 0;
+    double job_dt = 0;
+
+    std::atomic<uint64_t> tick_count{0};
+
+    void advance(int worker) {
+        int count = batch.size();
+        int chunk = (count + workers - 1) / workers;
+        int begin = std::min(count, worker * chunk);
+        int end = std::min(count, begin + chunk);
+
+        for (int k = begin; k < end; k++) {
+            int i = batch[k];
+            AircraftData& a = job_view->aircraft_data[i];
+            a.x += a.speedX * job_dt;
+            a.y += a.speedY * job_dt;
+            a.z += a.speedZ * job_dt;
+            a.lastupdatedTime = job_now;
+            syncHotFields(*job_view, i);
+        }
+    }
+
+    struct WorkerArgs {
+        SimulationEngine* engine;
+        int worker;
+    };
+
+    static void* workerThread(void* arg) {
+        WorkerArgs* args = static_cast<WorkerArgs*>(arg);
+        SimulationEngine* engine = args->engine;
+        int worker = args->worker;
+        delete args;
+
+        while (true) {
+            pthread_barrier_wait(&engine->start_barrier);
+            if (!engine->running) break;
+            engine->advance(worker);
+            pthread_barrier_wait(&engine->done_barrier);
+        }
+        return nullptr;
+    }
+
+    static void* tickThread(void* arg) {
+        SimulationEngine* engine = static_cast<SimulationEngine*>(arg);
+
+        // Absolute deadlines so the tick rate does not drift with load
+        timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        long period_ns = (long)(engine->period * 1e9);
+
+        while (engine->running) {
+            next.tv_nsec += period_ns;
+            next.tv_sec += next.tv_nsec / 1000000000;
+            next.tv_nsec %= 1000000000;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+            if (!engine->running) break;
+            engine->tick(engine->period);
+        }
+        return nullptr;
+    }
+
+public:
+    SimulationEngine(AirspaceMapping* airspace, int workers = 1, double period_sec = SIMULATION_TICK_SEC)
+        : airspace(airspace), workers(std::max(1, workers)), period(period_sec) {}
+
+    ~SimulationEngine() { stop(); }
+
+    void addSlot(int slot) {
+        pthread_mutex_lock(&slots_lock);
+        slots.push_back(slot);
+        pthread_mutex_unlock(&slots_lock);
+    }
+
+    void removeSlot(int slot) {
+        pthread_mutex_lock(&slots_lock);
+        slots.erase(std::remove(slots.begin(), slots.end(), slot), slots.end());
+        pthread_mutex_unlock(&slots_lock);
+    }
+
+    // Advances every registered slot by dt seconds in one write section.
+    // Called by the tick thread; exposed so a driver can step manually.
+    void tick(double dt) {
+        pthread_mutex_lock(&slots_lock);
+        batch = slots;
+        pthread_mutex_unlock(&slots_lock);
+
+        job_view = &airspace->beginWrite();
+        job_now = time(NULL);
+        job_dt = dt;
+        if (pool.empty()) {
+            advance(0);
+        } else {
+            pthread_barrier_wait(&start_barrier);
+            advance(0);
+            pthread_barrier_wait(&done_barrier);
+        }
+        markAirspaceFrame(job_view->header);
+        airspace->endWrite();
+        announceAirspaceFrame(job_view->header);
+
+        tick_count++;
+    }
+
+    void start() {
+        if (running) return;
+        running = true;
+
+        // Worker 0 is the tick thread itself
+        if (workers > 1) {
+            pthread_barrier_init(&start_barrier, NULL, workers);
+            pthread_barrier_init(&done_barrier, NULL, workers);
+            pool.resize(workers - 1);
+            for (int w = 1; w < workers; w++) {
+                pthread_create(&pool[w - 1], NULL, workerThread, new WorkerArgs{this, w});
+            }
+        }
+        pthread_create(&tick_thread, NULL, tickThread, this);
+    }
+
+    void stop() {
+        if (!running) return;
+        running = false;
+        pthread_join(tick_thread, NULL);
+
+        if (!pool.empty()) {
+            // Release the workers parked on the start barrier; they see !running
+            pthread_barrier_wait(&start_barrier);
+            for (pthread_t t : pool) pthread_join(t, NULL);
+            pool.clear();
+            pthread_barrier_destroy(&start_barrier);
+            pthread_barrier_destroy(&done_barrier);
+        }
+    }
+
+    // One airspace lock acquisition per tick, whatever the aircraft count
+    uint64_t ticks() const { return tick_count; }
+    int threadCount() const { return workers; }
+};
+
+#endif /* SIMULATION_ENGINE_H_ */
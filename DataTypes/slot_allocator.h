@@ -0,0 +1,110 @@
+/*
+ * slot_allocator.h
+ *
+ * Hands out airspace slots from a lock-free free list kept in the shared
+ * segment, so slots are reused when aircraft retire instead of the index
+ * only ever growing. Each slot carries a generation counter that is odd
+ * while the slot is allocated; a SlotHandle pairs the slot with the
+ * generation it was allocated at, so another process holding a handle
+ * can tell whether the slot still belongs to the same aircraft.
+ *
+ * allocateSlot() and releaseSlot() never take the airspace lock, but they
+ * must not overlap AirspaceMapping::grow(): the owner grows from the same
+ * thread that allocates, and releases inside the write section that
+ * clears the record.
+ */
+
+#ifndef SLOT_ALLOCATOR_H_
+#define SLOT_ALLOCATOR_H_
+
+#include <stdint.h>
+#include <atomic>
+#include "airspace.h"
+
+struct SlotHandle {
+	int32_t slot;
+	uint32_t generation;
+
+	bool valid() const { return slot >= 0; }
+};
+
+static const SlotHandle INVALID_SLOT = {-1, 0};
+
+// Pops a recycled slot, or takes the next never-used one. Returns
+// INVALID_SLOT when the segment is full; the owner then grows it and
+// tries again.
+inline SlotHandle allocateSlot(const AirspaceView& view) {
+	Airspace* h = view.header;
+	int32_t slot = -1;
+
+	uint64_t head = h->free_head.load(std::memory_order_acquire);
+	while ((uint32_t)head != 0) {
+		int32_t top = (uint32_t)head - 1;
+		uint64_t next = view.slot_next[top].load(std::memory_order_relaxed);
+		// The tag changes on every pop, so a slot popped and pushed back in
+		// the meantime cannot make a stale head compare equal
+		uint64_t replacement = ((head >> 32) + 1) << 32 | next;
+		if (h->free_head.compare_exchange_weak(head, replacement,
+		                                       std::memory_order_acq_rel,
+		                                       std::memory_order_acquire)) {
+			slot = top;
+			break;
+		}
+	}
+
+	if (slot < 0) {
+		int32_t high = h->high_water.load(std::memory_order_relaxed);
+		do {
+			if (high >= view.capacity) return INVALID_SLOT;
+		} while (!h->high_water.compare_exchange_weak(high, high + 1,
+		                                              std::memory_order_acq_rel,
+		                                              std::memory_order_relaxed));
+		slot = high;
+	}
+
+	uint32_t generation = view.slot_gen[slot].fetch_add(1, std::memory_order_acq_rel) + 1;
+	h->live_count.fetch_add(1, std::memory_order_relaxed);
+	return {slot, generation};
+}
+
+// True while the slot still holds the allocation the handle was made for
+inline bool isSlotCurrent(const AirspaceView& view, SlotHandle handle) {
+	return handle.slot >= 0 && handle.slot < view.capacity &&
+	       view.slot_gen[handle.slot].load(std::memory_order_acquire) == handle.generation;
+}
+
+// Returns the slot to the free list. A stale or repeated release is
+// refused rather than corrupting the list.
+inline bool releaseSlot(const AirspaceView& view, SlotHandle handle) {
+	if (!handle.valid() || handle.slot >= view.capacity) return false;
+
+	Airspace* h = view.header;
+	uint32_t generation = handle.generation;
+	if ((generation & 1) == 0 ||
+	    !view.slot_gen[handle.slot].compare_exchange_strong(generation, generation + 1,
+	                                                       std::memory_order_acq_rel)) {
+		return false;
+	}
+	h->live_count.fetch_sub(1, std::memory_order_relaxed);
+
+	uint64_t head = h->free_head.load(std::memory_order_relaxed);
+	uint64_t replacement;
+	do {
+		view.slot_next[handle.slot].store((uint32_t)head, std::memory_order_relaxed);
+		replacement = (head & 0xFFFFFFFF00000000ull) | (uint32_t)(handle.slot + 1);
+	} while (!h->free_head.compare_exchange_weak(head, replacement,
+	                                             std::memory_order_release,
+	                                             std::memory_order_relaxed));
+	return true;
+}
+
+// Scans can stop here: no slot at or above it has ever been allocated
+inline int slotHighWater(const AirspaceView& view) {
+	return std::min((int)view.header->high_water.load(std::memory_order_acquire), view.capacity);
+}
+
+inline int liveSlotCount(const AirspaceView& view) {
+	return view.header->live_count.load(std::memory_order_relaxed);
+}
+
+#endif /* SLOT_ALLOCATOR_H_ */
@@ -0,0 +1,164 @@
+/*
+ * spatial_grid.h
+ *
+ * Uniform grid broad phase for the separation checks. Cells are exactly
+ * as large as the separation minima, so two aircraft that have lost
+ * separation are always in the same cell or in one of its 26 neighbours.
+ */
+
+#ifndef SPATIAL_GRID_H_
+#define SPATIAL_GRID_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+#include "aircraft_data.h"
+#include "airspace.h"
+#include "separation.h"
+
+#define GRID_CELL_XY HORIZONTAL_SEPARATION
+#define GRID_CELL_Z  VERTICAL_SEPARATION
+
+class SpatialGrid {
+
+private:
+    // 21 bits per axis, biased so negative coordinates still pack.
+    static const int64_t AXIS_BIAS = 1 << 20;
+    static const uint64_t AXIS_MASK = (1u << 21) - 1;
+
+    struct Entry {
+        uint64_t key;
+        int index;
+        bool operator<(const Entry& o) const { return key < o.key; }
+    };
+
+    struct Cell {
+        uint64_t key;
+        int begin, end;
+    };
+
+    std::vector<Entry> entries;   // active aircraft sorted by cell key
+    std::vector<Cell> cells;      // one run of entries per occupied cell
+    std::vector<int> table;       // open addressing: key -> cells index
+    uint64_t table_mask = 0;
+
+    static uint64_t pack(int64_t ix, int64_t iy, int64_t iz) {
+        return ((uint64_t)(ix + AXIS_BIAS) & AXIS_MASK) << 42 |
+               ((uint64_t)(iy + AXIS_BIAS) & AXIS_MASK) << 21 |
+               ((uint64_t)(iz + AXIS_BIAS) & AXIS_MASK);
+    }
+
+    static uint64_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    int findCell(uint64_t key) const {
+        for (uint64_t slot = hash(key) & table_mask;; slot = (slot + 1) & table_mask) {
+            int c = table[slot];
+            if (c < 0) return -1;
+            if (cells[c].key == key) return c;
+        }
+    }
+
+    // Sorts the binned entries and builds the cell lookup table.
+    void index() {
+        std::sort(entries.begin(), entries.end());
+
+        for (int i = 0; i < (int)entries.size(); i++) {
+            if (cells.empty() || cells.back().key != entries[i].key) {
+                cells.push_back({entries[i].key, i, i + 1});
+            } else {
+                cells.back().end = i + 1;
+            }
+        }
+
+        size_t size = 16;
+        while (size < cells.size() * 2) size <<= 1;
+        table.assign(size, -1);
+        table_mask = size - 1;
+        for (int c = 0; c < (int)cells.size(); c++) {
+            uint64_t slot = hash(cells[c].key) & table_mask;
+            while (table[slot] >= 0) slot = (slot + 1) & table_mask;
+            table[slot] = c;
+        }
+    }
+
+public:
+    static uint64_t cellKey(double x, double y, double z) {
+        return pack((int64_t)std::floor(x / GRID_CELL_XY),
+                    (int64_t)std::floor(y / GRID_CELL_XY),
+                    (int64_t)std::floor(z / GRID_CELL_Z));
+    }
+
+    // Bins every aircraft that is in the air at `now`. Buffers are kept
+    // between cycles so a steady-state rebuild does not allocate.
+    void rebuild(const AircraftData* aircraft, int count, time_t now) {
+        entries.clear();
+        cells.clear();
+
+        for (int i = 0; i < count; i++) {
+            const AircraftData& a = aircraft[i];
+            if (a.id == 0 || now < a.entryTime) continue;
+            entries.push_back({cellKey(a.x, a.y, a.z), i});
+        }
+        index();
+    }
+
+    // Same, from the SoA mirror; only slots flagged active are binned.
+    void rebuild(const SoAView& hot, int count) {
+        entries.clear();
+        cells.clear();
+
+        for (int i = 0; i < count; i++) {
+            if (!hot.active[i]) continue;
+            entries.push_back({cellKey(hot.x[i], hot.y[i], hot.z[i]), i});
+        }
+        index();
+    }
+
+    int activeCount() const { return (int)entries.size(); }
+
+    // Calls fn(i, j) once for every unordered pair of aircraft indices in the
+    // same or adjacent cells. Only the 13 "forward" neighbours are visited
+    // from each cell so no pair is reported twice.
+    template <typename Fn>
+    void forEachCandidatePair(Fn fn) const {
+        static const int forward[13][3] = {
+            { 1, -1, -1}, { 1, -1, 0}, { 1, -1, 1},
+            { 1,  0, -1}, { 1,  0, 0}, { 1,  0, 1},
+            { 1,  1, -1}, { 1,  1, 0}, { 1,  1, 1},
+            { 0,  1, -1}, { 0,  1, 0}, { 0,  1, 1},
+            { 0,  0,  1}
+        };
+
+        for (const Cell& cell : cells) {
+            for (int p = cell.begin; p < cell.end; p++) {
+                for (int q = p + 1; q < cell.end; q++) {
+                    fn(entries[p].index, entries[q].index);
+                }
+            }
+
+            int64_t ix = (int64_t)((cell.key >> 42) & AXIS_MASK) - AXIS_BIAS;
+            int64_t iy = (int64_t)((cell.key >> 21) & AXIS_MASK) - AXIS_BIAS;
+            int64_t iz = (int64_t)(cell.key & AXIS_MASK) - AXIS_BIAS;
+
+            for (const int* d : forward) {
+                int n = findCell(pack(ix + d[0], iy + d[1], iz + d[2]));
+                if (n < 0) continue;
+                const Cell& other = cells[n];
+                for (int p = cell.begin; p < cell.end; p++) {
+                    for (int q = other.begin; q < other.end; q++) {
+                        fn(entries[p].index, entries[q].index);
+                    }
+                }
+            }
+        }
+    }
+};
+
+#endif /* SPATIAL_GRID_H_ */
@@ -0,0 +1,125 @@
+/*
+ * terminal_renderer.h
+ *
+ * Puts DisplayFrames on an ANSI terminal by rewriting only the cells that
+ * changed since the previous frame. Each changed run of a row is one
+ * cursor-position sequence followed by its characters; runs separated by
+ * a few unchanged cells are merged, since rewriting those is cheaper than
+ * another escape sequence. A frame goes out in a single write() from a
+ * buffer sized once for the worst case.
+ *
+ * The frame sits in the top FRAME_ROWS lines. Everything below is a
+ * scroll region for the command prompt and messages, and the cursor is
+ * saved and restored around every update, so typing is not disturbed.
+ */
+
+#ifndef TERMINAL_RENDERER_H_
+#define TERMINAL_RENDERER_H_
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "airspace_display.h"
+
+// Unchanged cells worth rewriting to avoid a new cursor sequence
+#define RENDER_MERGE_GAP 8
+
+class TerminalRenderer {
+
+private:
+    int fd;
+    DisplayFrame shown;
+    bool drawn = false;
+    size_t last_bytes = 0;
+
+    // Worst case: every cell, plus a cursor sequence (at most 10 bytes) for
+    // each run a row can split into, plus the set-up sequences
+    char out[FRAME_ROWS * (FRAME_COLUMNS + 10 * (FRAME_COLUMNS / (RENDER_MERGE_GAP + 1) + 1)) + 64];
+
+    static char* putCursor(char* at, int row, int col) {
+        return at + sprintf(at, "\x1b[%d;%dH", row + 1, col + 1);
+    }
+
+    bool writeAll(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t n = ::write(fd, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            size -= n;
+        }
+        return true;
+    }
+
+public:
+    explicit TerminalRenderer(int fd = STDOUT_FILENO) : fd(fd) {}
+
+    // Draws the frame, or only what changed since the last one. Returns
+    // false if the terminal could not be written.
+    bool render(const DisplayFrame& frame) {
+        char* at = out;
+        at += sprintf(at, "\x1b" "7");                      // save the cursor
+
+        if (!drawn) {
+            // Clear, keep the scroll region below the frame, and draw it all
+            at += sprintf(at, "\x1b[2J\x1b[%dr", FRAME_ROWS + 2);
+            for (int row = 0; row < FRAME_ROWS; row++) {
+                at = putCursor(at, row, 0);
+                memcpy(at, frame.cells[row], FRAME_COLUMNS);
+                at += FRAME_COLUMNS;
+            }
+        } else {
+            for (int row = 0; row < FRAME_ROWS; row++) {
+                const char* next = frame.cells[row];
+                const char* prev = shown.cells[row];
+                int col = 0;
+                while (col < FRAME_COLUMNS) {
+                    if (next[col] == prev[col]) {
+                        col++;
+                        continue;
+                    }
+                    int start = col, end = col + 1, same = 0;
+                    for (int c = end; c < FRAME_COLUMNS && same <= RENDER_MERGE_GAP; c++) {
+                        if (next[c] == prev[c]) {
+                            same++;
+                        } else {
+                            end = c + 1;
+                            same = 0;
+                        }
+                    }
+                    at = putCursor(at, row, start);
+                    memcpy(at, next + start, end - start);
+                    at += end - start;
+                    col = end;
+                }
+            }
+        }
+
+        at += sprintf(at, "\x1b" "8");                      // restore the cursor
+        if (!drawn) at += sprintf(at, "\x1b[%d;1H", FRAME_ROWS + 2);
+
+        last_bytes = at - out;
+        if (!writeAll(out, last_bytes)) return false;
+        shown = frame;
+        drawn = true;
+        return true;
+    }
+
+    // Redraw everything on the next render, e.g. after the terminal was
+    // resized or scrolled by other output
+    void invalidate() { drawn = false; }
+
+    // Gives the whole terminal back to scrolling
+    void release() {
+        static const char reset[] = "\x1b[r";
+        writeAll(reset, sizeof(reset) - 1);
+        drawn = false;
+    }
+
+    size_t lastBytes() const { return last_bytes; }
+};
+
+#endif /* TERMINAL_RENDERER_H_ */
@@ -0,0 +1,60 @@
+/*
+ * termination_thread.h
+ *
+ * Runs a process's shutdown work on a thread of its own. SIGINT and
+ * SIGTERM are blocked in every thread and taken with sigwait(), so the
+ * cleanup may lock, join and write files like any other code; a signal
+ * handler doing the same could interrupt a thread in the middle of stdio
+ * or malloc and deadlock or corrupt the heap.
+ *
+ * Start it before any other thread, so they all inherit the mask. Once
+ * the cleanup has run the signal is raised again with its default action,
+ * so the process still ends the way the signal would have ended it.
+ */
+
+#ifndef TERMINATION_THREAD_H_
+#define TERMINATION_THREAD_H_
+
+#include <pthread.h>
+#include <signal.h>
+
+typedef void (*TerminationCleanup)(int signum);
+
+inline void terminationSignals(sigset_t* set) {
+    sigemptyset(set);
+    sigaddset(set, SIGINT);
+    sigaddset(set, SIGTERM);
+}
+
+inline void* terminationThread(void* arg) {
+    TerminationCleanup cleanup = reinterpret_cast<TerminationCleanup>(arg);
+    sigset_t set;
+    terminationSignals(&set);
+
+    int signum = 0;
+    while (sigwait(&set, &signum) != 0) {
+    }
+    cleanup(signum);
+
+    signal(signum, SIG_DFL);
+    pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+    raise(signum);
+    return nullptr;
+}
+
+// Blocks SIGINT and SIGTERM in the calling thread and everything it
+// creates from now on, and hands them to cleanup on a detached thread
+inline bool startTerminationThread(TerminationCleanup cleanup) {
+    sigset_t set;
+    terminationSignals(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, terminationThread, reinterpret_cast<void*>(cleanup)) != 0) {
+        return false;
+    }
+    pthread_detach(thread);
+    return true;
+}
+
+#endif /* TERMINATION_THREAD_H_ */
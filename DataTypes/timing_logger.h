@@ -1,16 +1,71 @@
+/*
+ * timing_logger.h
+ *
+ * Durations are kept in one latency histogram per label and summarised
+ * to /tmp/timing/<filename> every flush period by a background thread,
+ * one line per label with samples in the period, plus totals for the
+ * whole run when the logger is closed. Recording a duration is a few
+ * atomic increments; nothing is formatted or written on the caller's
+ * thread, so the logger no longer shows up in what it measures.
+ *
+ * Setting TIMING_SAMPLES=1 in the environment also writes every sample
+ * as a line of text to /tmp/timing/<name>_samples.txt, as the logger used
+ * to, for debugging. Those lines are buffered and cost a formatted write
+ * per sample.
+ *
+ * Each label is also a histogram of the same name in the shared metrics
+ * registry (performance_metrics.h), so TracomTop shows it live.
+ */
+
 #ifndef TIMING_LOGGER_H
 #define TIMING_LOGGER_H
 
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <ctime>
+#include <atomic>
 #include <string>
-#include <fstream>
-#include <iomanip>
-#include <sstream>
 #include <sys/stat.h>
 #include <unistd.h>
+#include "latency_histogram.h"
+#include "performance_metrics.h"
+
+#define TIMING_FLUSH_SEC 10
+#define TIMING_MAX_LABELS 32
 
 class TimingLogger {
+    struct Series {
+        std::string label;
+        LatencyHistogram histogram;
+        MetricHistogram metric;
+        LatencySnapshot flushed;            // counts as of the last flush
+        uint64_t max_ns = 0;                // over the whole run
+
+        explicit Series(const char* label)
+            : label(label), metric(metrics().histogram(label)) {}
+    };
+
     std::string full_path;
+    std::string samples_path;
+    FILE* samples = nullptr;
+    int flush_sec;
+    timespec started;
+
+    // Labels are only ever added, so a lookup reads the published prefix
+    // of the table without a lock
+    std::atomic<Series*> series[TIMING_MAX_LABELS];
+    std::atomic<int> series_count;
+    pthread_mutex_t register_lock = PTHREAD_MUTEX_INITIALIZER;
+
+    pthread_mutex_t flush_lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t flush_wake = PTHREAD_COND_INITIALIZER;
+    pthread_t flush_thread;
+    bool flushing = false;
+    bool closed = false;
+    LatencySnapshot scratch;
 
     void ensureTimingDirExists() {
         struct stat st;
@@ -19,27 +74,164 @@ class TimingLogger {
         }
     }
 
+    Series* find(const char* label) {
+        int count = series_count.load(std::memory_order_acquire);
+        for (int i = 0; i < count; i++) {
+            Series* s = series[i].load(std::memory_order_relaxed);
+            if (s->label == label) return s;
+        }
+        return nullptr;
+    }
+
+    Series* add(const char* label) {
+        pthread_mutex_lock(&register_lock);
+        Series* s = find(label);
+        int count = series_count.load(std::memory_order_relaxed);
+        if (s == nullptr && count < TIMING_MAX_LABELS) {
+            s = new Series(label);
+            memset(&s->flushed, 0, sizeof(s->flushed));
+            series[count].store(s, std::memory_order_relaxed);
+            series_count.store(count + 1, std::memory_order_release);
+            if (count == 0) startFlushThread();
+        }
+        pthread_mutex_unlock(&register_lock);
+        return s;
+    }
+
+    static void* flushThread(void* arg) {
+        static_cast<TimingLogger*>(arg)->runFlush();
+        return nullptr;
+    }
+
+    // The thread inherits the mask with every signal blocked, so a
+    // termination handler that closes the logger never runs on it, nor
+    // here while the flush lock is held
+    void startFlushThread() {
+        sigset_t all, previous;
+        sigfillset(&all);
+        pthread_sigmask(SIG_SETMASK, &all, &previous);
+        pthread_mutex_lock(&flush_lock);
+        if (!closed) flushing = pthread_create(&flush_thread, NULL, flushThread, this) == 0;
+        pthread_mutex_unlock(&flush_lock);
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    }
+
+    void runFlush() {
+        pthread_mutex_lock(&flush_lock);
+        while (!closed) {
+            timespec wake;
+            clock_gettime(CLOCK_REALTIME, &wake);
+            wake.tv_sec += flush_sec;
+            pthread_cond_timedwait(&flush_wake, &flush_lock, &wake);
+            if (closed) break;
+            writeSummary(false);
+        }
+        pthread_mutex_unlock(&flush_lock);
+    }
+
+    static void printSummary(FILE* out, const char* period, const std::string& label,
+                             const LatencySnapshot& s) {
+        fprintf(out, "%-8s %-32s n=%-8llu mean=%.1f p50=%.1f p90=%.1f p99=%.1f p99.9=%.1f max=%.1f us\n",
+                period, label.c_str(), (unsigned long long)s.total, s.mean() / 1e3,
+                s.percentile(0.50) / 1e3, s.percentile(0.90) / 1e3,
+                s.percentile(0.99) / 1e3, s.percentile(0.999) / 1e3, s.max_ns / 1e3);
+    }
+
+    // One line per label with samples since the last flush; with totals,
+    // another per label covering the whole run
+    void writeSummary(bool totals) {
+        if (samples != nullptr) fflush(samples);
+
+        int count = series_count.load(std::memory_order_acquire);
+        if (count == 0) return;
+        FILE* out = fopen(full_path.c_str(), "a");
+        if (out == nullptr) return;
+
+        timespec now_ts = now();
+        char period[32];
+        snprintf(period, sizeof(period), "%lds", (long)(now_ts.tv_sec - started.tv_sec));
+
+        for (int i = 0; i < count; i++) {
+            Series* s = series[i].load(std::memory_order_relaxed);
+            s->histogram.snapshot(scratch);
+            if (scratch.max_ns > s->max_ns) s->max_ns = scratch.max_ns;
+
+            LatencySnapshot& interval = scratch;
+            uint64_t run_total = scratch.total;
+            interval.subtract(s->flushed);
+            if (interval.total > 0) printSummary(out, period, s->label, interval);
+
+            // Keep the cumulative counts for the next interval
+            for (int b = 0; b < LATENCY_BUCKETS; b++) s->flushed.counts[b] += interval.counts[b];
+            s->flushed.total = run_total;
+            s->flushed.sum_ns += interval.sum_ns;
+
+            if (totals && s->flushed.total > 0) {
+                s->flushed.max_ns = s->max_ns;
+                printSummary(out, "total", s->label, s->flushed);
+            }
+        }
+        fclose(out);
+    }
+
 public:
-    TimingLogger(const std::string& filename) {
+    TimingLogger(const std::string& filename, int flush_sec = TIMING_FLUSH_SEC)
+        : flush_sec(flush_sec > 0 ? flush_sec : 1), series_count(0) {
         ensureTimingDirExists();
         full_path = "/tmp/timing/" + filename;
+        started = now();
+        for (std::atomic<Series*>& s : series) s.store(nullptr, std::memory_order_relaxed);
+        memset(&scratch, 0, sizeof(scratch));
+
+        FILE* clear = fopen(full_path.c_str(), "w");
+        if (clear != nullptr) fclose(clear);
 
-        std::ofstream clear(full_path, std::ios::trunc);
-        clear.close();
+        const char* debug = getenv("TIMING_SAMPLES");
+        if (debug != nullptr && strcmp(debug, "0") != 0) {
+            size_t dot = filename.rfind('.');
+            samples_path = "/tmp/timing/" + filename.substr(0, dot) + "_samples" +
+                           (dot == std::string::npos ? "" : filename.substr(dot));
+            samples = fopen(samples_path.c_str(), "w");
+        }
     }
 
-    void logDuration(const std::string& label, const timespec& start, const timespec& end) {
-        std::ofstream out(full_path, std::ios::app);
-        if (!out.is_open()) return;
+    // The series and the samples file are left to the process: other
+    // threads may still be recording while static destructors run
+    ~TimingLogger() { close(); }
+
+    void logDuration(const char* label, const timespec& start, const timespec& end) {
+        int64_t ns = (int64_t)(end.tv_sec - start.tv_sec) * 1000000000LL +
+                     (end.tv_nsec - start.tv_nsec);
+        if (ns < 0) ns = 0;
 
-        double elapsed = (end.tv_sec - start.tv_sec) +
-                         (end.tv_nsec - start.tv_nsec) / 1e9;
+        Series* s = find(label);
+        if (s == nullptr) s = add(label);
+        if (s != nullptr) {
+            s->histogram.record(ns);
+            s->metric.record(ns);
+        }
+
+        if (samples != nullptr) {
+            // No need to print wall time if you're using CLOCK_MONOTONIC
+            fprintf(samples, "%s took %.9f sec\n", label, ns / 1e9);
+        }
+    }
 
-        // No need to print wall time if you're using CLOCK_MONOTONIC
-        out << label << " took "
-            << std::fixed << std::setprecision(9) << elapsed << " sec\n";
+    // Stops the flush thread and writes the last period and the run
+    // totals. Called on destruction; a process that ends by a signal
+    // calls it from its termination thread. Samples after this are still counted
+    // but not summarised.
+    void close() {
+        pthread_mutex_lock(&flush_lock);
+        bool first = !closed;
+        closed = true;
+        bool joinable = flushing;
+        pthread_cond_signal(&flush_wake);
+        pthread_mutex_unlock(&flush_lock);
+        if (!first) return;
 
-        out.close();
+        if (joinable) pthread_join(flush_thread, NULL);
+        writeSummary(true);
     }
 
     timespec now() const {
@@ -0,0 +1,107 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include "../../DataTypes/flight_recorder.h"
+
+using namespace std;
+
+// Renders recorded frames back to text.
+//
+//   FlightRecorderDump [file] --index        list the frames kept
+//   FlightRecorderDump [file] N              frame N
+//   FlightRecorderDump [file] N-M            frames N to M
+//   FlightRecorderDump [file]                the latest frame
+
+string format_time(int64_t timestamp_ns) {
+    time_t sec = timestamp_ns / 1000000000LL;
+    tm* timeinfo = localtime(&sec);
+    char timeBuffer[64];
+    strftime(timeBuffer, sizeof(timeBuffer), "%Y-%m-%d %H:%M:%S", timeinfo);
+
+    char out[80];
+    snprintf(out, sizeof(out), "%s.%03d", timeBuffer, (int)(timestamp_ns / 1000000 % 1000));
+    return out;
+}
+
+void print_index(FlightRecording& recording) {
+    uint64_t first = recording.firstFrame(), end = recording.endFrame();
+    cout << "Frames " << first << " to " << (end == 0 ? 0 : end - 1)
+         << " (" << end - first << " kept)\n";
+
+    cout << left << setw(10) << "frame" << setw(26) << "time"
+         << setw(12) << "offset" << setw(10) << "bytes" << "type\n";
+    for (uint64_t f = first; f < end; f++) {
+        FrameIndexEntry e;
+        if (!recording.frameInfo(f, e)) continue;
+        cout << setw(10) << f << setw(26) << format_time(e.timestamp_ns)
+             << setw(12) << e.offset << setw(10) << e.length
+             << ((e.flags & FRAME_KEYFRAME) ? "key" : "delta") << '\n';
+    }
+}
+
+bool print_frame(FlightRecording& recording, uint64_t frame) {
+    static vector<RecordedAircraft> aircraft;
+    FrameHeader info;
+    if (!recording.readFrame(frame, aircraft, &info)) {
+        cerr << "Frame " << frame << " is not in the recording\n";
+        return false;
+    }
+
+    cout << "=== Frame " << frame << " at " << format_time(info.timestamp_ns)
+         << " (" << ((info.flags & FRAME_KEYFRAME) ? "keyframe" : "delta")
+         << ", " << info.record_count << " records, " << aircraft.size() << " aircraft) ===\n";
+
+    cout << fixed << setprecision(2);
+    for (const RecordedAircraft& a : aircraft) {
+        cout << "Aircraft " << a.id
+             << " | Pos: (" << a.x << ", " << a.y << ", " << a.z << ")"
+             << " | Vel: (" << a.vx << ", " << a.vy << ", " << a.vz << ")"
+             << ((a.status & CONTACT_DETECTED) ? " | detected" : "")
+             << ((a.status & CONTACT_RESPONDED) ? " | responded" : "") << '\n';
+    }
+    cout << '\n';
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = FLIGHT_RECORDER_PATH;
+    const char* what = nullptr;
+
+    if (argc > 2) {
+        path = argv[1];
+        what = argv[2];
+    } else if (argc > 1) {
+        // A lone argument is a frame selection unless it names a file
+        bool selection = strcmp(argv[1], "--index") == 0 ||
+                         strspn(argv[1], "0123456789-") == strlen(argv[1]);
+        if (selection) what = argv[1];
+        else path = argv[1];
+    }
+
+    FlightRecording recording;
+    if (!recording.open(path)) return EXIT_FAILURE;
+
+    if (recording.endFrame() == 0) {
+        cout << "Recording is empty\n";
+        return EXIT_SUCCESS;
+    }
+
+    if (what != nullptr && strcmp(what, "--index") == 0) {
+        print_index(recording);
+        return EXIT_SUCCESS;
+    }
+
+    uint64_t first = recording.endFrame() - 1, last = first;
+    if (what != nullptr) {
+        char* rest;
+        first = last = strtoull(what, &rest, 10);
+        if (*rest == '-') last = strtoull(rest + 1, NULL, 10);
+    }
+
+    bool ok = true;
+    for (uint64_t f = first; f <= last; f++) ok &= print_frame(recording, f);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
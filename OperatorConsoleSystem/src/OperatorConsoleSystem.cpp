@@ -8,48 +8,68 @@
 #include <fcntl.h>
 #include <sys/dispatch.h>
 #include "../../DataTypes/operator_command.h"
+#include "../../DataTypes/command_ring.h"
+#include "../../DataTypes/alert_ring.h"
 
-OperatorCommandMemory* operator_cmd_mem = nullptr;
+CommandRing* command_ring = nullptr;
+// The ring takes a single producer; stdin and the IPC listener share it
+pthread_mutex_t command_push_lock = PTHREAD_MUTEX_INITIALIZER;
+AlertRing* alert_ring = nullptr;
 
-name_attach_t* init_operator_violation_channel() {
-    name_attach_t* attach = name_attach(NULL, OPERATOR_VIOLATIONS_CHANNEL_NAME, 0);
-    if (attach == NULL) {
-        perror("[ComputerSystem] Failed to attach operator violations channel");
-        exit(EXIT_FAILURE);
-    }
+AlertRing* connect_to_alert_ring() {
+    struct timespec one_sec = {1, 0};
 
-    std::cout << "[ComputerSystem] IPC channel for operator violations established: "
-              << OPERATOR_VIOLATIONS_CHANNEL_NAME << std::endl;
+    while (true) {
+        int shm_fd = shm_open(ALERT_RING_SHM_NAME, O_RDWR, 0666);
+        if (shm_fd != -1) {
+            void* addr = mmap(NULL, sizeof(AlertRing), PROT_READ | PROT_WRITE,
+                              MAP_SHARED, shm_fd, 0);
+            close(shm_fd);
+            if (addr != MAP_FAILED) {
+                AlertRing* ring = static_cast<AlertRing*>(addr);
+                // The ComputerSystem sets the magic once the cells are ready
+                if (ring->magic == ALERT_RING_MAGIC) {
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    std::cout << "[OperatorConsole] Connected to alert ring.\n";
+                    return ring;
+                }
+                munmap(addr, sizeof(AlertRing));
+            } else {
+                perror("[OperatorConsole] mmap failed for alert ring");
+            }
+        }
 
-    return attach;
+        nanosleep(&one_sec, NULL);
+    }
 }
 
-OperatorCommandMemory* connect_to_operator_command_memory() {
-    int shm_fd;
-    void* addr = MAP_FAILED;
+CommandRing* connect_to_command_ring() {
     struct timespec one_sec = {1, 0};  // 1 second, 0 nanoseconds
 
     while (true) {
-        shm_fd = shm_open(OPERATOR_COMMAND_SHM_NAME, O_RDWR, 0666);
+        int shm_fd = shm_open(OPERATOR_COMMAND_SHM_NAME, O_RDWR, 0666);
         if (shm_fd != -1) {
-            addr = mmap(NULL, sizeof(OperatorCommandMemory),
-                        PROT_READ | PROT_WRITE, MAP_SHARED,
-                        shm_fd, 0);
+            void* addr = mmap(NULL, sizeof(CommandRing),
+                              PROT_READ | PROT_WRITE, MAP_SHARED,
+                              shm_fd, 0);
+            close(shm_fd);
             if (addr != MAP_FAILED) {
-                std::cout << "[OperatorConsole] Connected to shared memory for commands.\n";
-                close(shm_fd);
-                return static_cast<OperatorCommandMemory*>(addr);
+                CommandRing* ring = static_cast<CommandRing*>(addr);
+                // The ComputerSystem sets the magic once the ring is ready
+                if (ring->magic == COMMAND_RING_MAGIC) {
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    std::cout << "[OperatorConsole] Connected to shared memory for commands.\n";
+                    return ring;
+                }
+                munmap(addr, sizeof(CommandRing));
             } else {
                 perror("[OperatorConsole] mmap failed");
-                close(shm_fd);
             }
         } else {
             perror("[OperatorConsole] shm_open failed (retrying)");
         }
 
-
         nanosleep(&one_sec, NULL);
-
     }
 }
 
@@ -83,54 +103,77 @@ void log_operator_command(const std::string& raw_cmd) {
 
 
 void handle_received_command(const std::string& raw_cmd) {
-    const double UNSET = -1.0;
-
     log_operator_command(raw_cmd);
 
-    std::istringstream ss(raw_cmd);
+    OperatorCommand cmd;
     std::string type;
-    int aircraft_id;
-    double x = UNSET, y = UNSET, z = UNSET;
-
-    ss >> type >> aircraft_id >> x >> y >> z;
-
-    OperatorCommand cmd = {};
-    cmd.aircraft_id = aircraft_id;
-    cmd.timestamp = time(NULL);
-
-    if (type == "ChangeSpeed") {
-        cmd.type = CommandType::ChangeSpeed;
-        cmd.speed = {x, y, z};
-        cmd.position = {UNSET, UNSET, UNSET};
-    } else if (type == "ChangePosition") {
-        cmd.type = CommandType::ChangePosition;
-        cmd.position = {x, y, z};
-        cmd.speed = {UNSET, UNSET, UNSET};
-    } else if (type == "RequestDetails") {
-        cmd.type = CommandType::RequestDetails;
-        cmd.position = {UNSET, UNSET, UNSET};
-        cmd.speed = {UNSET, UNSET, UNSET};
-    } else if (type == "ALERT:"){
-
-    }
-    else {
+    if (!parseOperatorCommand(raw_cmd, cmd, type)) {
         std::cerr << "[OperatorConsole] Unknown command type: " << type << std::endl;
         return;
     }
 
-    pthread_mutex_lock(&operator_cmd_mem->lock);
-    if (operator_cmd_mem->command_count < MAX_OPERATOR_COMMANDS) {
-        operator_cmd_mem->commands[operator_cmd_mem->command_count++] = cmd;
-        operator_cmd_mem->updated = true;
+    pthread_mutex_lock(&command_push_lock);
+    bool stored = pushCommand(command_ring, cmd);
+    pthread_mutex_unlock(&command_push_lock);
 
+    if (stored) {
         std::cout << "[OperatorConsole] Stored command for aircraft " << cmd.aircraft_id << std::endl;
     } else {
-        std::cerr << "[OperatorConsole] Command memory full.\n";
+        std::cerr << "[OperatorConsole] Command ring full, command dropped.\n";
     }
-    pthread_mutex_unlock(&operator_cmd_mem->lock);
 }
 
 
+void print_alert(const AlertRecord& alert) {
+    if (alert.state == ALERT_RESOLVED) {
+        printf("[OperatorConsole] %s %s: Aircraft %d and Aircraft %d separated again (%.0f m horizontal, %.0f m vertical)\n",
+               alertSeverityName(alert.severity), alertStateName(alert.state),
+               alert.aircraft1, alert.aircraft2, alert.horizontal, alert.vertical);
+    } else if (alert.kind == ALERT_LOSS_OF_SEPARATION) {
+        printf("[OperatorConsole] %s %s: Aircraft %d and Aircraft %d are too close (%.0f m horizontal, %.0f m vertical)\n",
+               alertSeverityName(alert.severity), alertStateName(alert.state),
+               alert.aircraft1, alert.aircraft2, alert.horizontal, alert.vertical);
+    } else {
+        printf("[OperatorConsole] %s %s: Aircraft %d and Aircraft %d lose separation in %.0f s (CPA %.0f m)\n",
+               alertSeverityName(alert.severity), alertStateName(alert.state),
+               alert.aircraft1, alert.aircraft2, alert.time_to_conflict, alert.horizontal);
+    }
+}
+
+void print_alert_stats() {
+    std::cout << "[OperatorConsole] Alerts pushed: " << alert_ring->pushed.load()
+              << ", dropped: " << alert_ring->dropped.load()
+              << ", duplicates suppressed: " << alert_ring->suppressed.load() << std::endl;
+}
+
+// Takes alerts off the ring a batch at a time and only sleeps when it is empty
+void* alertDrainThread(void* arg) {
+    AlertRing* ring = static_cast<AlertRing*>(arg);
+    AlertRecord batch[ALERT_DRAIN_BATCH];
+    struct timespec idle = {0, 100000000};  // 100 ms
+    uint64_t reported_drops = 0;
+
+    while (true) {
+        int count = drainAlerts(ring, batch, ALERT_DRAIN_BATCH);
+
+        for (int i = 0; i < count; i++) {
+            //TURN ON ALERT
+            //print_alert(batch[i]);
+        }
+
+        uint64_t dropped = ring->dropped.load(std::memory_order_relaxed);
+        if (dropped != reported_drops) {
+            std::cerr << "[OperatorConsole] " << dropped - reported_drops
+                      << " alerts dropped, ring full\n";
+            reported_drops = dropped;
+        }
+
+        if (count < ALERT_DRAIN_BATCH) nanosleep(&idle, NULL);
+    }
+
+    return nullptr;
+}
+
 void* ipcListenerThread(void* arg) {
     name_attach_t* attach = static_cast<name_attach_t*>(arg);
 
@@ -148,15 +191,8 @@ void* ipcListenerThread(void* arg) {
         msg[255] = '\0';
         std::string received_cmd(msg);
 
-        if (received_cmd.find("ALERT") == std::string::npos) {
-        	std::cout << "\n[OperatorConsole] Received command via IPC: " << received_cmd << std::endl;
-            handle_received_command(received_cmd);  // Only called if "ALERT" is NOT found
-        }
-        else{
-        	//TURN ON ALERT
-        	//std::cout << "\n[OperatorConsole] Received Alert via IPC: " << received_cmd << std::endl;
-
-        }
+        std::cout << "\n[OperatorConsole] Received command via IPC: " << received_cmd << std::endl;
+        handle_received_command(received_cmd);
 
         MsgReply(rcvid, 0, NULL, 0);
     }
@@ -167,7 +203,7 @@ void* ipcListenerThread(void* arg) {
 
 int main() {
 	clear_operator_logfile();
-    operator_cmd_mem = connect_to_operator_command_memory();
+    command_ring = connect_to_command_ring();
 
     // Attach channel
     name_attach_t* attach = name_attach(NULL, OPERATOR_CONSOLE_CHANNEL_NAME, 0);
@@ -181,10 +217,9 @@ int main() {
     pthread_t listenerThread;
     pthread_create(&listenerThread, nullptr, ipcListenerThread, attach);
 
-    name_attach_t* operator_violation_channel = nullptr;
-    operator_violation_channel = init_operator_violation_channel();
-    pthread_t violationListenerThread;
-    pthread_create(&violationListenerThread, nullptr, ipcListenerThread, operator_violation_channel);
+    alert_ring = connect_to_alert_ring();
+    pthread_t alertThread;
+    pthread_create(&alertThread, nullptr, alertDrainThread, alert_ring);
 
     // Main thread handles stdin input for testing
     std::string input;
@@ -194,6 +229,11 @@ int main() {
 
         if (input == "exit") break;
 
+        if (input == "alerts") {
+            print_alert_stats();
+            continue;
+        }
+
         if (!input.empty()) {
             handle_received_command(input);
         }
@@ -1,88 +1,83 @@
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/neutrino.h>
 #include <unistd.h>
+#include <csignal>
 #include <iostream>
+#include <iomanip>
 #include <pthread.h>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <vector>
 #include <regex>
+#include <algorithm>
 #include "RadarSubsystem.h"
 #include "../../DataTypes/aircraft_data.h"
 #include "../../DataTypes/aircraft.h"
+#include "../../DataTypes/slot_allocator.h"
+#include "../../DataTypes/active_index.h"
+#include "../../DataTypes/connection_cache.h"
+#include "../../DataTypes/interrogation_pool.h"
 #include "../../DataTypes/timing_logger.h"
+#include "../../DataTypes/termination_thread.h"
+#include "../../DataTypes/flight_recorder.h"
+#include "../../DataTypes/radar_coverage.h"
 
 using namespace std;
 
 TimingLogger logger("radar.txt");
 
-Airspace* airspace = nullptr;
+AirspaceMapping airspace;
 std::vector<Aircraft*> active_aircrafts;
-int shm_fd_airspace;
 pthread_mutex_t shm_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_t airspace_thread;
-pthread_t message_thread;
+InterrogationPool* interrogations = nullptr;
+FlightRecorder recorder;
+
+int open_aircraft_channel(int id) {
+	char server_name[20];
+	snprintf(server_name, sizeof(server_name), "Aircraft%d", id);
+	return name_open(server_name, 0);
+}
+
+// Interrogations reuse the connection of an aircraft already pinged
+ConnectionCache aircraft_connections(open_aircraft_channel,
+                                     [](int coid) { name_close(coid); });
 
 
-Airspace* init_airspace_shared_memory() {
+void init_airspace_shared_memory() {
     std::cout << "[RadarSubsystem] Waiting for Airspace shared memory to become available...\n";
     struct timespec wait_time = {1, 0};
-    while (true) {
-        shm_fd_airspace = shm_open(AIRSPACE_SHM_NAME, O_RDWR, 0666);
-        if (shm_fd_airspace != -1) {
-            break;
-        }
+    while (!airspace.attach(AIRSPACE_SHM_NAME, true)) {
         nanosleep(&wait_time, NULL);
     }
 
-    void* addr = mmap(NULL, sizeof(Airspace), PROT_READ | PROT_WRITE,
-                      MAP_SHARED, shm_fd_airspace, 0);
-    if (addr == MAP_FAILED) {
-        perror("mmap failed for aircraft data");
-        exit(1);
-    }
-
-    std::cout << "[RadarSubsystem] Connected to Airspace shared memory at " << addr << "\n";
-    return static_cast<Airspace*>(addr);
-}
-
-void clear_airspace_logfile() {
-    std::ofstream logfile("/tmp/airspace_history.txt", std::ios::trunc);
-    if (!logfile.is_open()) {
-        perror("[RadarSubsystem] Failed to clear airspace history log");
-        return;
-    }
-    logfile << "[RadarSubsystem] Airspace history log initialized.\n\n";
-    logfile.close();
+    std::cout << "[RadarSubsystem] Connected to Airspace shared memory at " << airspace.header()
+              << " (" << airspace.capacity() << " slots)\n";
 }
 
-
-void log_airspace_history() {
-    std::ofstream logfile("/tmp/airspace_history.txt", std::ios::app);
-    if (!logfile.is_open()) {
-        perror("[RadarSubsystem] Failed to open airspace history log");
-        return;
-    }
-
-    time_t now = time(NULL);
-    tm* timeinfo = localtime(&now);
-    char timeBuffer[64];
-    strftime(timeBuffer, sizeof(timeBuffer), "%Y-%m-%d %H:%M:%S", timeinfo);
-
-    logfile << "=== Snapshot at " << timeBuffer << " ===\n";
-
-    for (int i = 0; i < airspace->aircraft_count; ++i) {
-        AircraftData& a = airspace->aircraft_data[i];
-        if (a.id == 0) continue;
-
-        logfile << "Aircraft " << a.id
-                << " | Pos: (" << a.x << ", " << a.y << ", " << a.z << ")"
-                << " | Vel: (" << a.speedX << ", " << a.speedY << ", " << a.speedZ << ")\n";
+// What one sweep needs from a slot, copied out of shared memory
+struct RadarContact {
+    SlotHandle slot;       // which aircraft the slot held when copied
+    int id;
+    double x, y, z;
+    double speedX, speedY, speedZ;
+    bool responded;
+};
+
+std::vector<RadarContact> contacts;
+
+// One frame per sweep, written outside the airspace lock
+void record_sweep(const std::vector<RadarContact>& snapshot, const std::vector<bool>& inside) {
+    static std::vector<RecordedAircraft> frame;
+    frame.clear();
+    for (size_t i = 0; i < snapshot.size(); i++) {
+        const RadarContact& a = snapshot[i];
+        uint32_t status = (inside[i] ? CONTACT_DETECTED : 0) | (a.responded ? CONTACT_RESPONDED : 0);
+        frame.push_back({a.slot.slot, a.id, a.x, a.y, a.z, a.speedX, a.speedY, a.speedZ, status});
     }
-
-    logfile << '\n';
-    logfile.close();
+    recorder.record(frame);
 }
 
 
@@ -91,62 +86,79 @@ void* updateAirspaceDetectionThread(void* arg) {
 		    req.tv_sec = 1;         // 1 second
 		    req.tv_nsec = 0;        // 0 nanoseconds
 
-    time_t last_log_time = time(NULL);
+    std::vector<bool> inside;
 
 	while (true) {
 		timespec start = logger.now();
-		pthread_mutex_lock(&airspace->lock);
-
-		for(int i = 0; i < airspace->aircraft_count; ++i) {
-			AircraftData* aircraft = &airspace->aircraft_data[i];
-
-			if (aircraft->x > 100000 || aircraft->y > 100000 ||
-				aircraft->x < 0 || aircraft->y < 0 || aircraft->z > 25000 ||
-				aircraft->z < 15000) {
-				aircraft->detected = false;
-			} else {
-				aircraft->detected = true;
-				if (aircraft->responded == false) {
-					cout << "Aircraft " << aircraft->id << " has not been pinged, starting secondary radar...\n";
-					pthread_create(&message_thread, NULL, send_message, (void*)&aircraft->id);
-
-					pthread_join(message_thread, NULL);
-					cout << "[RADAR] Thread joined\n";
-					aircraft->responded = true;
-				}
-			}
+
+		// Sweep a consistent copy; the position threads are never blocked by it
+		airspace.read([&](const AirspaceView& hot) {
+			contacts.clear();
+			forEachActiveSlot(hot, [&](int i) {
+				const AircraftData& a = hot.aircraft_data[i];
+				SlotHandle slot = {i, hot.slot_gen[i].load(std::memory_order_relaxed)};
+				contacts.push_back({slot, a.id, hot.x[i], hot.y[i], hot.z[i],
+				                    hot.vx[i], hot.vy[i], hot.vz[i], a.responded});
+			});
+		});
+
+		int count = contacts.size();
+		inside.assign(count, false);
+		for (int i = 0; i < count; ++i) {
+			const RadarContact& c = contacts[i];
+			inside[i] = inRadarCoverage(c.x, c.y, c.z);
 		}
 
-		time_t now = time(NULL);
-		if (now - last_log_time >= 20) {
-			log_airspace_history();
-			last_log_time = now;
+		// Publishing the flags is the only part that needs the write lock.
+		// A slot recycled since the copy now holds another aircraft; skip it.
+		const AirspaceView& view = airspace.beginWrite();
+		for (int i = 0; i < count; ++i) {
+			if (!isSlotCurrent(view, contacts[i].slot)) continue;
+			view.aircraft_data[contacts[i].slot.slot].detected = inside[i];
 		}
-		pthread_mutex_unlock(&airspace->lock);
+		airspace.endWrite();
+
+		// Hand new contacts to the interrogation workers; the sweep never
+		// waits for a reply. Aircraft already being interrogated are skipped.
+		for (int i = 0; i < count; ++i) {
+			const RadarContact& c = contacts[i];
+			if (!inside[i] || c.responded) continue;
+
+			if (interrogations->submit(c.id, c.slot)) {
+				cout << "Aircraft " << c.id << " has not been pinged, starting secondary radar...\n";
+			}
+		}
+
+		timespec recorded = logger.now();
+		record_sweep(contacts, inside);
 		timespec end = logger.now();
+		logger.logDuration("recordFrame", recorded, end);
 		logger.logDuration("updateAirspaceDetectionThread", start, end);
 		nanosleep(&req, NULL);
 	}
 	return nullptr;
 }
 
-void* send_message(void* arg) {
-	int id = *(int*)arg;
-
+// Runs on an interrogation worker. Gives up at the request's deadline,
+// both while the aircraft's channel is not up yet and while waiting for
+// its reply.
+InterrogationOutcome interrogate_aircraft(const InterrogationRequest& request) {
+	int id = request.aircraft_id;
 	int coid;
 	char server_name[20];
-	struct timespec wait_time = {1, 0};
+	struct timespec retry = {0, 100000000};
 
 	snprintf(server_name, sizeof(server_name), "Aircraft%d", id);
 
-	cout << "[DEBUG] server_name: " << server_name << endl;
-
-	// Wait until the server becomes available
-	while ((coid = name_open(server_name, 0)) == -1) {
-		cout << "Waiting for server " << server_name << "to start...\n";
-		nanosleep(&wait_time, NULL);
+	// Wait until the server becomes available; once it is, the connection
+	// stays cached for the next interrogation
+	while ((coid = aircraft_connections.acquire(id)) == -1) {
+		if (InterrogationPool::remainingMs(request.deadline) == 0) {
+			return INTERROGATION_TIMED_OUT;
+		}
+		nanosleep(&retry, NULL);
 	}
-	cout << "Connected to server '" << server_name << "'\n";
+	aircraft_connections.release(coid);
 
 	RadarMessage radar_message;
 	strcpy(radar_message.request_msg, "Plz identify yourself and send heading");
@@ -156,45 +168,89 @@ void* send_message(void* arg) {
 	msg.aircraft_id = id;
 	msg.message.radar_message = radar_message;
 
-
 	RadarReply reply;
 
-	int status = MsgSend(coid, &msg, sizeof(msg), &reply, sizeof(reply));
-    if (status == -1) {
-        perror("MsgSend");
-    }
+	int status = aircraft_connections.send(id, [&](int coid) {
+		// Bound the whole send/reply by what is left of the deadline
+		uint64_t timeout_ns = InterrogationPool::remainingMs(request.deadline) * 1000000ULL;
+		TimerTimeout(CLOCK_MONOTONIC, _NTO_TIMEOUT_SEND | _NTO_TIMEOUT_REPLY,
+		             NULL, &timeout_ns, NULL);
+		return MsgSend(coid, &msg, sizeof(msg), &reply, sizeof(reply));
+	});
+	if (status == -1) {
+		if (errno == ETIMEDOUT) return INTERROGATION_TIMED_OUT;
+		perror("MsgSend");
+		return INTERROGATION_FAILED;
+	}
 
-    cout << fixed << setprecision(1);
+	tm* timeinfo = localtime(&reply.timestamp);
+	char timeBuffer[64];
+	strftime(timeBuffer, sizeof(timeBuffer), "%Y-%m-%d %H:%M:%S", timeinfo);
 
-    tm* timeinfo = localtime(&reply.timestamp);
-    char timeBuffer[64];
-    strftime(timeBuffer, sizeof(timeBuffer), "%Y-%m-%d %H:%M:%S", timeinfo);
+	string delimiter = string(50, '=');
 
-    string delimiter = string(50, '=');
+	// One write, so replies from parallel workers do not interleave
+	ostringstream out;
+	out << fixed << setprecision(1) << left;
+	out << delimiter << '\n';
+	out << setw(15) << "Timestamp:"    << timeBuffer << '\n';
+	out << setw(15) << "Aircraft ID:"  << reply.id << '\n';
+	out << setw(15) << "Position:"     << "(" << reply.x << ", " << reply.y << ", " << reply.z << ")" << '\n';
+	out << setw(15) << "Velocity:"     << "(" << reply.speedX << ", " << reply.speedY << ", " << reply.speedZ << ")" << '\n';
+	out << delimiter << '\n';
+	cout << out.str();
 
-    cout << delimiter << '\n';
-    cout << left;
-    cout << setw(15) << "Timestamp:"    << timeBuffer << '\n';
-    cout << setw(15) << "Aircraft ID:"  << reply.id << '\n';
-    cout << setw(15) << "Position:"     << "(" << reply.x << ", " << reply.y << ", " << reply.z << ")" << '\n';
-    cout << setw(15) << "Velocity:"     << "(" << reply.speedX << ", " << reply.speedY << ", " << reply.speedZ << ")" << '\n';
-    cout << delimiter << '\n';
+	return INTERROGATION_REPLIED;
+}
+
+// Completion callback, on the worker that ran the interrogation. Only a
+// reply marks the aircraft; after a failure or timeout the next sweep
+// queues it again.
+void on_interrogated(const InterrogationRequest& request, InterrogationOutcome outcome) {
+	if (outcome != INTERROGATION_REPLIED) {
+		cout << "[RADAR] Aircraft " << request.aircraft_id
+		     << (outcome == INTERROGATION_TIMED_OUT ? " did not answer in time\n" : " interrogation failed\n");
+		return;
+	}
 
-    name_close(coid);
-    return nullptr;
+	const AirspaceView& view = airspace.beginWrite();
+	if (isSlotCurrent(view, request.slot)) {
+		view.aircraft_data[request.slot.slot].responded = true;
+	}
+	airspace.endWrite();
 }
 
 void cleanUpOnExit() {
 	pthread_join(airspace_thread, nullptr);
+	interrogations->stop();
 }
 
-int main() {
+// Writes the timing totals; runs on the termination thread, not in a
+// signal handler, and the signal then ends the process as before
+void handle_termination(int) {
+	logger.close();
+}
+
+int main(int argc, char* argv[]) {
+	startTerminationThread(handle_termination);
+
+	// Optional arguments: interrogation workers, max interrogations in
+	// flight, per-interrogation timeout in ms
+	int workers = argc > 1 ? atoi(argv[1]) : DEFAULT_INTERROGATION_WORKERS;
+	int max_in_flight = argc > 2 ? atoi(argv[2]) : DEFAULT_MAX_IN_FLIGHT;
+	long timeout_ms = argc > 3 ? atol(argv[3]) : DEFAULT_INTERROGATION_TIMEOUT_MS;
+
+	if (!recorder.create(FLIGHT_RECORDER_PATH)) {
+		std::cerr << "[RadarSubsystem] Flight recorder disabled\n";
+	}
 
-	clear_airspace_logfile();
+    init_airspace_shared_memory();
 
-    airspace = init_airspace_shared_memory();
+    interrogations = new InterrogationPool(interrogate_aircraft, on_interrogated,
+                                           workers, std::max(1, max_in_flight), timeout_ms);
+    interrogations->start();
 
-    std::cout << "[DEBUG] Shared Memory Base Address for Aircrafts: " << airspace << std::endl;
+    std::cout << "[DEBUG] Shared Memory Base Address for Aircrafts: " << airspace.header() << std::endl;
 
 	pthread_create(&airspace_thread, nullptr, updateAirspaceDetectionThread, NULL);
 
@@ -207,8 +263,7 @@ int main() {
 
     while (true) nanosleep(&req, NULL);
 
-    munmap(airspace, sizeof(Airspace));
-    close(shm_fd_airspace);
+    airspace.close(false);
 
     cleanUpOnExit();
 
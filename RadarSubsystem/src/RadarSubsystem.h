@@ -9,10 +9,12 @@
 #define SRC_RADARSUBSYSTEM_H_
 
 #include "../../DataTypes/aircraft.h"
+#include "../../DataTypes/interrogation_pool.h"
 
-Airspace* init_airspace_shared_memory();
+void init_airspace_shared_memory();
 void* updateAirspaceDetectionThread(void*);
-void* send_message(void*);
+InterrogationOutcome interrogate_aircraft(const InterrogationRequest&);
+void on_interrogated(const InterrogationRequest&, InterrogationOutcome);
 void fake_aircraft_data();
 void verify_aircraft_data();
 
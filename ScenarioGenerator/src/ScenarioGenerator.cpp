@@ -0,0 +1,290 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "../../DataTypes/radar_coverage.h"
+#include "../../DataTypes/scenario_loader.h"
+#include "../../DataTypes/separation.h"
+
+using namespace std;
+
+// Writes synthetic traffic scenarios for scale testing, in the text form
+// the AirspaceManager reads from /tmp/aircraft_data.txt and in the binary
+// form of scenario_loader.h.
+//
+//   ScenarioGenerator [options]
+//     -n count          aircraft (default 1000)
+//     -s seed           same seed and options, same scenario (default 1)
+//     -d seconds        entries spread over this long (default 600)
+//     -e distribution   uniform | poisson | burst | instant (default uniform)
+//     -a low:high       altitude band in m, within 15000:25000 (default all of it)
+//     -v low:high       horizontal speed in m/s (default 100:300)
+//     -c density        share of aircraft flown in conflicting pairs, 0-1 (default 0.05)
+//     -t epoch          absolute entry times from this epoch (default: seconds after load)
+//     -o path           text output, "-" for none (default /tmp/aircraft_data.txt)
+//     -b path           binary output (default none)
+
+#define SECTOR_SIZE RADAR_RANGE_XY
+#define BURST_COUNT 10
+
+struct GeneratorOptions {
+    long count = 1000;
+    uint64_t seed = 1;
+    double duration = 600;
+    string distribution = "uniform";
+    double altitude_low = RADAR_FLOOR, altitude_high = RADAR_CEILING;
+    double speed_low = 100, speed_high = 300;
+    double conflict_density = 0.05;
+    long long epoch = 0;
+    string text_path = "/tmp/aircraft_data.txt";
+    string binary_path;
+};
+
+struct GeneratedAircraft {
+    uint32_t entry;             // seconds after the scenario start
+    double x, y, z, vx, vy, vz;
+};
+
+// The engine's output is fixed by the standard, the library distributions
+// are not, so the draws are done here to get the same scenario everywhere
+class Draw {
+    mt19937_64 rng;
+
+public:
+    explicit Draw(uint64_t seed) : rng(seed) {}
+
+    double unit() { return (rng() >> 11) * (1.0 / 9007199254740992.0); }   // [0, 1)
+    double uniform(double low, double high) { return low + (high - low) * unit(); }
+    double exponential(double mean) { return -mean * log(1.0 - unit()); }
+};
+
+// Entry times for n events, sorted
+vector<double> entry_times(const GeneratorOptions& o, long n, Draw& draw) {
+    vector<double> times(n);
+    if (o.distribution == "poisson") {
+        double t = 0, mean = n > 0 ? o.duration / n : 0;
+        for (double& e : times) e = (t += draw.exponential(mean));
+    } else if (o.distribution == "burst") {
+        // Waves of arrivals, each spread over a twentieth of its interval
+        double interval = o.duration / BURST_COUNT;
+        for (double& e : times) {
+            double wave = floor(draw.unit() * BURST_COUNT) * interval;
+            e = wave + draw.uniform(0, interval / 20);
+        }
+    } else if (o.distribution == "instant") {
+        fill(times.begin(), times.end(), 0.0);
+    } else {
+        for (double& e : times) e = draw.uniform(0, o.duration);
+    }
+    sort(times.begin(), times.end());
+    return times;
+}
+
+// Cm resolution, so the text and binary forms hold the same values
+double to_cm(double v) {
+    return round(v * 100) / 100;
+}
+
+GeneratedAircraft make_aircraft(double entry, double x, double y, double z,
+                                double heading, double speed, double climb) {
+    return {(uint32_t)entry, to_cm(x), to_cm(y), to_cm(z),
+            to_cm(speed * cos(heading)), to_cm(speed * sin(heading)), to_cm(climb)};
+}
+
+// A pair that loses separation over a point in the middle of the sector:
+// both are placed back along their tracks from the meeting point, the
+// second crossing at 60-300 degrees, laterally offset by less than the
+// horizontal minimum and within a few hundred metres in altitude.
+// Leads are kept short enough that both start inside the sector.
+void add_conflict_pair(const GeneratorOptions& o, double entry, Draw& draw,
+                       vector<GeneratedAircraft>& out) {
+    const double reach = SECTOR_SIZE * 0.4;     // meeting point to sector edge
+    double mx = draw.uniform(SECTOR_SIZE * 0.4, SECTOR_SIZE * 0.6);
+    double my = draw.uniform(SECTOR_SIZE * 0.4, SECTOR_SIZE * 0.6);
+    double z = draw.uniform(o.altitude_low, o.altitude_high);
+
+    double heading_a = draw.uniform(0, 2 * M_PI);
+    double heading_b = heading_a + draw.uniform(M_PI / 3, 5 * M_PI / 3);
+    double speed_a = draw.uniform(o.speed_low, o.speed_high);
+    double speed_b = draw.uniform(o.speed_low, o.speed_high);
+
+    double stagger = floor(draw.uniform(0, 30));
+    double lead = draw.uniform(30, 90);
+    lead = min(lead, reach / max(speed_b, 1.0));
+    lead = min(lead, reach / max(speed_a, 1.0) - stagger);
+    if (lead < 5) {
+        stagger = 0;
+        lead = min(reach / max(speed_a, 1.0), reach / max(speed_b, 1.0));
+    }
+    lead = floor(lead);
+
+    double miss = draw.uniform(0, HORIZONTAL_SEPARATION * 0.8);
+    double bx = mx + miss * cos(heading_b + M_PI / 2);
+    double by = my + miss * sin(heading_b + M_PI / 2);
+    double zb = min(o.altitude_high, max(o.altitude_low,
+                    z + draw.uniform(-VERTICAL_SEPARATION * 0.3, VERTICAL_SEPARATION * 0.3)));
+
+    double ta = lead + stagger, tb = lead;
+    out.push_back(make_aircraft(entry, mx - speed_a * ta * cos(heading_a),
+                                my - speed_a * ta * sin(heading_a), z, heading_a, speed_a, 0));
+    out.push_back(make_aircraft(entry + stagger, bx - speed_b * tb * cos(heading_b),
+                                by - speed_b * tb * sin(heading_b), zb, heading_b, speed_b, 0));
+}
+
+vector<GeneratedAircraft> generate(const GeneratorOptions& o, long& pairs) {
+    Draw draw(o.seed);
+
+    pairs = (long)(o.count * o.conflict_density / 2);
+    long background = o.count - 2 * pairs;
+    vector<double> times = entry_times(o, background + pairs, draw);
+
+    // Pairs are spread evenly through the arrival sequence
+    vector<GeneratedAircraft> traffic;
+    traffic.reserve(o.count);
+    long every = pairs > 0 ? (background + pairs) / pairs : 0;
+    long placed_pairs = 0;
+    for (size_t k = 0; k < times.size(); k++) {
+        bool pair = placed_pairs < pairs && every > 0 && k % every == 0;
+        if (pair) {
+            add_conflict_pair(o, times[k], draw, traffic);
+            placed_pairs++;
+            continue;
+        }
+        // One draw per statement: argument evaluation order is unspecified
+        double x = draw.uniform(0, SECTOR_SIZE);
+        double y = draw.uniform(0, SECTOR_SIZE);
+        double z = draw.uniform(o.altitude_low, o.altitude_high);
+        double heading = draw.uniform(0, 2 * M_PI);
+        double speed = draw.uniform(o.speed_low, o.speed_high);
+        double climb = draw.unit() < 0.8 ? 0 : draw.uniform(-10, 10);
+        traffic.push_back(make_aircraft(times[k], x, y, z, heading, speed, climb));
+    }
+    pairs = placed_pairs;
+
+    stable_sort(traffic.begin(), traffic.end(),
+                [](const GeneratedAircraft& a, const GeneratedAircraft& b) {
+                    return a.entry < b.entry;
+                });
+    return traffic;
+}
+
+bool write_text(const GeneratorOptions& o, const vector<GeneratedAircraft>& traffic) {
+    FILE* out = fopen(o.text_path.c_str(), "w");
+    if (out == nullptr) {
+        perror("[ScenarioGenerator] Unable to open text output");
+        return false;
+    }
+    static char buffer[1 << 20];
+    setvbuf(out, buffer, _IOFBF, sizeof(buffer));
+
+    fprintf(out, "# ScenarioGenerator -n %ld -s %llu -d %g -e %s -a %g:%g -v %g:%g -c %g\n",
+            o.count, (unsigned long long)o.seed, o.duration, o.distribution.c_str(),
+            o.altitude_low, o.altitude_high, o.speed_low, o.speed_high, o.conflict_density);
+    for (size_t k = 0; k < traffic.size(); k++) {
+        const GeneratedAircraft& a = traffic[k];
+        fprintf(out, "%lld %zu %.2f %.2f %.2f %.2f %.2f %.2f\n",
+                o.epoch + (long long)a.entry, k + 1, a.x, a.y, a.z, a.vx, a.vy, a.vz);
+    }
+    bool ok = !ferror(out);
+    ok &= fclose(out) == 0;
+    if (!ok) perror("[ScenarioGenerator] Writing text output failed");
+    return ok;
+}
+
+bool write_binary(const GeneratorOptions& o, const vector<GeneratedAircraft>& traffic) {
+    FILE* out = fopen(o.binary_path.c_str(), "wb");
+    if (out == nullptr) {
+        perror("[ScenarioGenerator] Unable to open binary output");
+        return false;
+    }
+
+    ScenarioFileHeader header = {SCENARIO_BINARY_MAGIC, SCENARIO_BINARY_VERSION,
+                                 traffic.size(), o.epoch};
+    fwrite(&header, sizeof(header), 1, out);
+
+    vector<ScenarioRecord> records(traffic.size());
+    for (size_t k = 0; k < traffic.size(); k++) {
+        const GeneratedAircraft& a = traffic[k];
+        ScenarioRecord& r = records[k];
+        r.entry_offset = a.entry;
+        r.id = k + 1;
+        r.position_cm[0] = lround(a.x * 100);
+        r.position_cm[1] = lround(a.y * 100);
+        r.position_cm[2] = lround(a.z * 100);
+        r.speed_cm[0] = lround(a.vx * 100);
+        r.speed_cm[1] = lround(a.vy * 100);
+        r.speed_cm[2] = lround(a.vz * 100);
+    }
+    fwrite(records.data(), sizeof(ScenarioRecord), records.size(), out);
+
+    bool ok = !ferror(out);
+    ok &= fclose(out) == 0;
+    if (!ok) perror("[ScenarioGenerator] Writing binary output failed");
+    return ok;
+}
+
+bool parse_range(const char* arg, double& low, double& high) {
+    return sscanf(arg, "%lf:%lf", &low, &high) == 2 && low <= high;
+}
+
+void usage(const char* name) {
+    cerr << "Usage: " << name << " [-n count] [-s seed] [-d seconds]"
+         << " [-e uniform|poisson|burst|instant] [-a low:high] [-v low:high]"
+         << " [-c density] [-t epoch] [-o text|-] [-b binary]\n";
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorOptions o;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:d:e:a:v:c:t:o:b:")) != -1) {
+        bool ok = true;
+        switch (opt) {
+        case 'n': o.count = atol(optarg); ok = o.count >= 0; break;
+        case 's': o.seed = strtoull(optarg, NULL, 10); break;
+        case 'd': o.duration = atof(optarg); ok = o.duration >= 0; break;
+        case 'e': o.distribution = optarg;
+                  ok = o.distribution == "uniform" || o.distribution == "poisson" ||
+                       o.distribution == "burst" || o.distribution == "instant";
+                  break;
+        case 'a': ok = parse_range(optarg, o.altitude_low, o.altitude_high); break;
+        case 'v': ok = parse_range(optarg, o.speed_low, o.speed_high) && o.speed_low >= 0; break;
+        case 'c': o.conflict_density = atof(optarg);
+                  ok = o.conflict_density >= 0 && o.conflict_density <= 1;
+                  break;
+        case 't': o.epoch = atoll(optarg); ok = o.epoch >= 100000000; break;
+        case 'o': o.text_path = strcmp(optarg, "-") == 0 ? "" : optarg; break;
+        case 'b': o.binary_path = optarg; break;
+        default:  ok = false; break;
+        }
+        if (!ok) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Everything stays inside the radar's altitude window
+    if (o.altitude_low < RADAR_FLOOR || o.altitude_high > RADAR_CEILING) {
+        cerr << "Altitude band must lie within " << RADAR_FLOOR << ":" << RADAR_CEILING << "\n";
+        return EXIT_FAILURE;
+    }
+
+    long pairs;
+    vector<GeneratedAircraft> traffic = generate(o, pairs);
+
+    bool ok = true;
+    if (!o.text_path.empty()) ok &= write_text(o, traffic);
+    if (!o.binary_path.empty()) ok &= write_binary(o, traffic);
+
+    cout << "Generated " << traffic.size() << " aircraft (" << pairs << " conflicting pairs), "
+         << o.distribution << " entries over " << o.duration << " s, seed " << o.seed << "\n";
+    if (!o.text_path.empty()) cout << "  text:   " << o.text_path << "\n";
+    if (!o.binary_path.empty()) cout << "  binary: " << o.binary_path << "\n";
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,10 +1,15 @@
 #include <iostream>
 #include <cstdlib>
 #include <unistd.h>
+#include <sys/mman.h>
+#include "../../DataTypes/performance_metrics.h"
 
 int main() {
     std::cout << "[TracomSystemLauncher] Launching all subsystems...\n";
 
+    // Each run counts from zero; the first subsystem up creates the registry
+    shm_unlink(METRICS_SHM_NAME);
+
     // 1. Launch ComputerSystem
     if (system("./ComputerSystem &") == -1) {
         std::cerr << "Failed to launch ComputerSystem\n";
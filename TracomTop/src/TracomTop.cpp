@@ -0,0 +1,194 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "../../DataTypes/performance_metrics.h"
+
+using namespace std;
+
+// Samples the shared metrics registry and shows what changed, like top.
+//
+//   TracomTop [seconds]          refresh every so many seconds (default 1)
+//   TracomTop --once             print the run totals once and exit
+//
+// Counters show their total and rate, gauges their level, histograms the
+// samples per second and the mean and percentiles of the last interval.
+// Percentiles are the upper bound of their bucket, so within a factor of
+// two. Only reads the segment; the subsystems never notice.
+
+#define TOP_DEFAULT_INTERVAL_SEC 1
+
+struct Sample {
+    uint32_t kind;
+    int64_t value;
+    uint64_t sum_ns;
+    uint64_t buckets[METRICS_BUCKETS];
+};
+
+Sample previous[METRICS_MAX];
+Sample current[METRICS_MAX];
+
+// Maps the registry read-only, or returns nullptr if nobody created it yet
+const MetricsSegment* map_segment() {
+    int fd = shm_open(METRICS_SHM_NAME, O_RDONLY, 0);
+    if (fd == -1) return nullptr;
+    void* addr = mmap(NULL, sizeof(MetricsSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return nullptr;
+
+    const MetricsSegment* segment = static_cast<const MetricsSegment*>(addr);
+    if (!metricsSegmentReady(segment)) {
+        munmap(addr, sizeof(MetricsSegment));
+        return nullptr;
+    }
+    return segment;
+}
+
+const MetricsSegment* wait_for_segment() {
+    const MetricsSegment* segment;
+    bool told = false;
+    while ((segment = map_segment()) == nullptr) {
+        if (!told) cout << "[TracomTop] Waiting for " << METRICS_SHM_NAME << "...\n";
+        told = true;
+        sleep(1);
+    }
+    return segment;
+}
+
+// The launcher starts each run on a fresh segment; follow it there
+const MetricsSegment* follow_restart(const MetricsSegment* segment) {
+    const MetricsSegment* latest = map_segment();
+    if (latest == nullptr) return segment;
+    if (latest->created == segment->created) {
+        munmap((void*)latest, sizeof(MetricsSegment));
+        return segment;
+    }
+    munmap((void*)segment, sizeof(MetricsSegment));
+    return latest;
+}
+
+int take_sample(const MetricsSegment* segment, Sample* out) {
+    int count = 0;
+    for (int i = 0; i < METRICS_MAX; i++) {
+        const MetricSlot& slot = segment->metrics[i];
+        uint32_t kind = slot.kind.load(std::memory_order_acquire);
+        if (kind == METRIC_FREE) break;
+
+        Sample& s = out[i];
+        s.kind = kind;
+        s.value = slot.value.load(std::memory_order_relaxed);
+        s.sum_ns = slot.sum_ns.load(std::memory_order_relaxed);
+        for (int b = 0; b < METRICS_BUCKETS; b++) {
+            s.buckets[b] = slot.buckets[b].load(std::memory_order_relaxed);
+        }
+        count = i + 1;
+    }
+    return count;
+}
+
+// Upper bound of the bucket holding quantile q of the interval, in us
+double interval_percentile(const Sample& now, const Sample& before, uint64_t total, double q) {
+    uint64_t rank = (uint64_t)(q * total + 0.999999);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < METRICS_BUCKETS; b++) {
+        seen += now.buckets[b] - before.buckets[b];
+        if (seen >= rank) return metricBucketLimit(b) / 1e3;
+    }
+    return metricBucketLimit(METRICS_BUCKETS - 1) / 1e3;
+}
+
+void print_sample(const MetricsSegment* segment, int count, double interval_sec, bool totals) {
+    time_t now = time(NULL);
+    time_t created = (time_t)segment->created;
+    char clock[16], since[32];
+    strftime(clock, sizeof(clock), "%H:%M:%S", localtime(&now));
+    strftime(since, sizeof(since), "%Y-%m-%d %H:%M:%S", localtime(&created));
+
+    cout << "tracom-top  " << clock << "  metrics since " << since << "  ("
+         << count << " registered)\n\n";
+
+    cout << left << setw(32) << "counter / gauge" << setw(11) << "kind"
+         << right << setw(14) << "value" << setw(12) << "per sec" << "\n";
+    cout << fixed << setprecision(1);
+    for (int i = 0; i < count; i++) {
+        const Sample& s = current[i];
+        if (s.kind != METRIC_COUNTER && s.kind != METRIC_GAUGE) continue;
+        cout << left << setw(32) << segment->metrics[i].name << setw(11) << metricKindName(s.kind)
+             << right << setw(14) << s.value;
+        if (s.kind == METRIC_COUNTER && !totals) {
+            cout << setw(12) << (s.value - previous[i].value) / interval_sec;
+        }
+        cout << "\n";
+    }
+
+    cout << "\n" << left << setw(32) << "histogram" << right << setw(10) << "samples"
+         << setw(10) << "per sec" << setw(11) << "mean us" << setw(11) << "p50 us"
+         << setw(11) << "p99 us" << setw(12) << "max us" << "\n";
+    for (int i = 0; i < count; i++) {
+        const Sample& s = current[i];
+        if (s.kind != METRIC_HISTOGRAM) continue;
+
+        // Totals compare with an empty sample, intervals with the last one
+        static const Sample empty = {};
+        const Sample& before = totals ? empty : previous[i];
+        uint64_t n = s.value - before.value;
+        cout << left << setw(32) << segment->metrics[i].name << right << setw(10) << s.value;
+        cout << setw(10) << (totals ? 0.0 : n / interval_sec);
+        if (n > 0) {
+            cout << setw(11) << (s.sum_ns - before.sum_ns) / 1e3 / n
+                 << setw(11) << interval_percentile(s, before, n, 0.50)
+                 << setw(11) << interval_percentile(s, before, n, 0.99);
+        } else {
+            cout << setw(11) << "-" << setw(11) << "-" << setw(11) << "-";
+        }
+        cout << setw(12) << segment->metrics[i].max_ns.load(std::memory_order_relaxed) / 1e3 << "\n";
+    }
+    cout << flush;
+}
+
+int main(int argc, char* argv[]) {
+    bool once = argc > 1 && strcmp(argv[1], "--once") == 0;
+    double interval_sec = TOP_DEFAULT_INTERVAL_SEC;
+    if (argc > 1 && !once) {
+        interval_sec = atof(argv[1]);
+        if (interval_sec <= 0) {
+            cerr << "Usage: " << argv[0] << " [seconds | --once]\n";
+            return 1;
+        }
+    }
+
+    const MetricsSegment* segment = wait_for_segment();
+    if (once) {
+        int count = take_sample(segment, current);
+        print_sample(segment, count, 1, true);
+        return 0;
+    }
+
+    bool on_terminal = isatty(STDOUT_FILENO);
+    take_sample(segment, previous);
+    timespec period;
+    period.tv_sec = (time_t)interval_sec;
+    period.tv_nsec = (long)((interval_sec - period.tv_sec) * 1e9);
+
+    while (true) {
+        nanosleep(&period, NULL);
+        const MetricsSegment* latest = follow_restart(segment);
+        if (latest != segment) {
+            segment = latest;
+            take_sample(segment, previous);
+            continue;
+        }
+
+        int count = take_sample(segment, current);
+        if (on_terminal) cout << "\x1b[H\x1b[2J";
+        print_sample(segment, count, interval_sec, false);
+        if (!on_terminal) cout << "\n";
+        memcpy(previous, current, sizeof(previous));
+    }
+    return 0;
+}